@@ -1,19 +1,19 @@
 #include "code_generator.h"
 #include <utility>
 
-CodeGenerator::CodeGenerator(Tree<Symbol> _ast,
-                             std::map<std::string, std::map<std::string, SymbolTableEntry>> _symbol_table,
-                             std::string output_file_name) {
-    ast = _ast;
-    symbol_table = std::move(_symbol_table);
+CodeGenerator::CodeGenerator(Program *_program, const SymbolTable &_symbol_table, const TypeTable &_types,
+                             std::string output_file_name)
+        : symbol_table(_symbol_table), types(_types) {
+    program = _program;
+    locals = &symbol_table;
     out_address = std::move(output_file_name);
     current_func = "";
     temp_var_counter = 0;
     included_headers = {"stdio.h", "stdlib.h", "stdbool.h"};
 }
 
-std::string CodeGenerator::to_c_type(semantic_type stype) {
-    switch (stype) {
+std::string CodeGenerator::to_c_type(type_id type) {
+    switch (types.kind(type)) {
         case INT:
             return "int";
         case BOOL:
@@ -24,19 +24,28 @@ std::string CodeGenerator::to_c_type(semantic_type stype) {
             // This is now mainly a fallback for pointers, as declarations are handled specially.
             return "void*";
         case TUPLE:
-            return "struct tuple";
+            // one struct per distinct tuple type, named by its type id
+            return type == TUPLE ? "struct tuple" : "struct tuple_" + std::to_string(type);
         default:
             return "int"; // Default for UNK type
     }
 }
 
-std::string CodeGenerator::to_c_type(const std::vector<semantic_type> &types) {
-    if (types.empty()) return "void";
+// `int x`, or `int x[2][3]` for an array of arrays
+std::string CodeGenerator::to_c_declaration(type_id type, const std::string &name) {
+    if (types.kind(type) == ARRAY && type != ARRAY) {
+        const TypeInfo &info = types[type];
+        return to_c_declaration(info.element, name + "[" + std::to_string(info.length) + "]");
+    }
+    return to_c_type(type) + " " + name;
+}
 
+std::string CodeGenerator::to_c_definition(type_id tuple) {
+    const std::vector<type_id> &elements = types[tuple].elements;
     std::stringstream ss;
-    ss << "struct tuple_" << types.size() << " {";
-    for (size_t i = 0; i < types.size(); ++i) {
-        ss << to_c_type(types[i]) << " item" << i << ";";
+    ss << to_c_type(tuple) << " {";
+    for (size_t i = 0; i < elements.size(); ++i) {
+        ss << to_c_declaration(elements[i], "item" + std::to_string(i)) << ";";
     }
     ss << "}";
     return ss.str();
@@ -54,138 +63,100 @@ std::string CodeGenerator::indent_block(const std::string &block_code) {
     return result;
 }
 
-std::string CodeGenerator::generate_assignment_or_call_statement(Node<Symbol> *stmt_node) {
-    auto children = stmt_node->get_children();
-    // Structure: <stmt> -> T_Id <stmt_after_id> T_Semicolon
-
-    std::string identifier = children[0]->get_data().get_content();
-    Node<Symbol> *after_id_node = children[1];
-    Node<Symbol> *first_child_of_after = after_id_node->get_children()[0];
-    std::string rule_type = first_child_of_after->get_data().get_name();
-
-    std::string code = "\t";
-
-    if (rule_type == "T_Assign") {
-        // Simple assignment: identifier = expression;
-        code += identifier + " = " + generate_expression(after_id_node->get_children()[1]);
-    } else if (rule_type == "T_LB") {
-        // Array element assignment: identifier[index_expression] = value_expression;
-        // Grammar: T_LB <exp> T_RB T_Assign <exp>
-        code += identifier
-                + "[" + generate_expression(after_id_node->get_children()[1]) + "]"
-                + " = "
-                + generate_expression(after_id_node->get_children()[4]);
-    } else if (rule_type == "T_LP") {
-        // Function call as a statement. We can reuse the existing function call generator.
-        // We just need to build a fake <arith_factor> node for it.
-        // Or more simply, build the string manually.
-        std::string func_call_str = identifier + "(";
-        Node<Symbol> *exp_ls_call_node = after_id_node->get_children()[1];
-        if (!exp_ls_call_node->get_children().empty() &&
-            exp_ls_call_node->get_children()[0]->get_data().get_name() != "eps") {
-            func_call_str += generate_expression(exp_ls_call_node->get_children()[0]);
-        }
-        func_call_str += ")";
-        code += func_call_str;
-    }
-
-    code += ";\n";
-    return code;
-}
-
-std::string CodeGenerator::generate_code(Node<Symbol> *node) {
-    if (!node) return "";
+std::string CodeGenerator::generate_code(AstNode *node) {
+    if (node == nullptr) return "";
 
-    std::string head_name = node->get_data().get_name();
-    auto children = node->get_children();
     std::string code;
 
-    if (head_name == "program" || head_name == "func_ls" || head_name == "stmt_ls") {
-        for (auto child: children) {
-            code += generate_code(child);
-        }
-    } else if (head_name == "stmt" && !children.empty() && children[0]->get_data().get_name() == "T_Id") {
-        code = generate_assignment_or_call_statement(node);
-    } else if (head_name == "func") {
-        code = generate_function(node);
-    } else if (head_name == "var_declaration") {
-        code = generate_variable_declaration(node);
-    } else if (head_name == "println_stmt") {
-        code = generate_println(node);
-    } else if (head_name == "if_stmt" || head_name == "loop_stmt" ||
-               head_name == "break_stmt" || head_name == "continue_stmt") {
-        code = generate_control_structures(node);
-    } else if (head_name == "return_stmt") {
-        if (!children.empty() && children[0]->get_data().get_name() != "eps") {
-            code = "\treturn " + generate_expression(children[1]) + ";\n";
-        }
-    } else if (head_name == "exp" || head_name == "log_exp" || head_name == "rel_exp" ||
-               head_name == "eq_exp" || head_name == "cmp_exp" || head_name == "arith_exp" ||
-               head_name == "arith_term" || head_name == "arith_factor") {
-        code = generate_expression(node);
-    } else if (head_name == "T_Id" || head_name == "T_Decimal" || head_name == "T_Hexadecimal") {
-        code = node->get_data().get_content();
-    } else if (head_name == "T_True") {
-        code = "true";
-    } else if (head_name == "T_False") {
-        code = "false";
-    } else if (head_name == "T_String") {
-        std::string content = node->get_data().get_content();
-        size_t pos = 0;
-        while ((pos = content.find('\"', pos))) {
-            content.replace(pos, 1, "\\\"");
-            pos += 2;
+    switch (node->kind) {
+        case AST_PROGRAM:
+            for (auto item: static_cast<Program *>(node)->items) {
+                code += generate_code(item);
+            }
+            break;
+        case AST_BLOCK:
+            for (auto stmt: static_cast<Block *>(node)->stmts) {
+                code += generate_code(stmt);
+            }
+            break;
+        case AST_FUNC_DECL:
+            code = generate_function(static_cast<FuncDecl *>(node));
+            break;
+        case AST_LET:
+            code = generate_variable_declaration(static_cast<Let *>(node));
+            break;
+        case AST_ASSIGN: {
+            auto *assign = static_cast<Assign *>(node);
+            code = "\t" + assign->name + " = " + generate_expression(assign->value) + ";\n";
+            break;
         }
-        code = "\"" + content + "\"";
-    } else if (!children.empty()) {
-        for (auto child: children) {
-            code += generate_code(child);
+        case AST_INDEX_ASSIGN: {
+            auto *assign = static_cast<IndexAssign *>(node);
+            code = "\t" + assign->name
+                   + "[" + generate_expression(assign->index) + "]"
+                   + " = "
+                   + generate_expression(assign->value) + ";\n";
+            break;
         }
+        case AST_CALL_STMT:
+            code = "\t" + generate_expression(static_cast<CallStmt *>(node)->call) + ";\n";
+            break;
+        case AST_IF:
+            code = generate_if(static_cast<If *>(node));
+            break;
+        case AST_LOOP:
+            code = "\twhile (1) {\n";
+            code += generate_code(static_cast<Loop *>(node)->body);
+            code += "\t}\n";
+            break;
+        case AST_BREAK:
+            code = "\tbreak;\n";
+            break;
+        case AST_CONTINUE:
+            code = "\tcontinue;\n";
+            break;
+        case AST_PRINTLN:
+            code = generate_println(static_cast<Println *>(node));
+            break;
+        default:
+            if (node->kind >= AST_BINARY) {
+                code = generate_expression(static_cast<Expr *>(node));
+            }
+            break;
     }
 
     return code;
 }
 
-std::string CodeGenerator::generate_variable_declaration(Node<Symbol> *node) {
-    auto children = node->get_children();
+std::string CodeGenerator::generate_variable_declaration(Let *let) {
     std::string code;
 
-    bool is_mutable = !children[1]->get_children().empty() &&
-                      children[1]->get_children()[0]->get_data().get_name() == "T_Mut";
-
-    Node<Symbol> *pattern_node = children[2];
-
     // This handles single variable declarations (`let x ...`).
     // It does not handle tuple destructuring (`let (x,y) ...`) yet.
-    if (!pattern_node->get_children().empty() && pattern_node->get_children()[0]->get_data().get_name() == "T_Id") {
-        std::string var_name = pattern_node->get_children()[0]->get_data().get_content();
+    if (!let->tuple_pattern) {
+        std::string var_name = let->names[0];
 
         // Retrieve the variable's information from the symbol table.
         // This assumes SemanticAnalyzer has already run and populated the table correctly.
-        SymbolTableEntry var_entry = symbol_table[current_func][var_name];
-        semantic_type var_type = var_entry.get_stype();
+        const SymbolTableEntry &var_entry = (*locals)[let->symbols[0]];
+        type_id var_type = var_entry.get_stype();
 
         code += "\t";
-        if (!is_mutable) {
+        if (!let->mut) {
             code += "const ";
         }
 
         // Generate the type and name part of the declaration
-        if (var_type == ARRAY) {
-            semantic_type element_type = var_entry.get_arr_type();
-            int array_len = var_entry.get_arr_len();
-            code += to_c_type(element_type) + " " + var_name + "[" + std::to_string(array_len) + "]";
-        } else {
-            // This handles INT, BOOL, and other simple types.
-            // If SemanticAnalyzer is fixed, this will correctly use 'int' for 'y'.
-            code += to_c_type(var_type) + " " + var_name;
-        }
+        code += to_c_declaration(var_type, var_name);
 
         // Handle initialization if it exists
-        Node<Symbol> *assign_opt_node = children[4];
-        if (!assign_opt_node->get_children().empty() &&
-            assign_opt_node->get_children()[0]->get_data().get_name() != "eps") {
-            code += " = " + generate_expression(assign_opt_node->get_children()[1]);
+        if (let->init != nullptr) {
+            // a call folded to an array or a tuple becomes its initializer
+            if (let->init->kind == AST_CALL && let->init->constant.known()) {
+                code += " = " + generate_constant(let->init->constant, let->init->type);
+            } else {
+                code += " = " + generate_expression(let->init);
+            }
         }
 
         code += ";\n";
@@ -203,30 +174,27 @@ void CodeGenerator::run() {
     }
     final_code += "\n";
 
-    std::set<std::vector<semantic_type>> tuple_types;
-    for (const auto &scope: symbol_table) {
-        for (const auto &symbol: scope.second) {
-            const auto &tuple_types_vec = symbol.second.get_tuple_types();
-            if (!tuple_types_vec.empty()) {
-                tuple_types.insert(tuple_types_vec);
-            }
+    // an element type is entered before the tuple holding it, so id order defines it first
+    for (type_id type = 0; type < types.size(); type++) {
+        if (types.kind(type) == TUPLE && type != TUPLE) {
+            final_code += to_c_definition(type) + ";\n";
         }
     }
-
-    for (const auto &types: tuple_types) {
-        final_code += to_c_type(types) + ";\n";
-    }
     final_code += "\n";
 
-    auto funcs = symbol_table[""];
+    // prototypes in name order
+    std::map<std::string, int> funcs;
+    for (int func: symbol_table.get_functions()) {
+        funcs[symbol_table[func].get_name()] = func;
+    }
     for (const auto &func: funcs) {
         if (func.first != "main") {
-            semantic_type return_type = func.second.get_stype();
+            type_id return_type = symbol_table[func.second].get_stype();
             final_code += to_c_type(return_type) + " " + func.first + "(";
 
-            const auto &params = func.second.get_parameters();
+            const auto &params = symbol_table[func.second].get_parameters();
             for (size_t i = 0; i < params.size(); ++i) {
-                final_code += to_c_type(params[i].second) + " " + params[i].first;
+                final_code += to_c_declaration(params[i].second, params[i].first);
                 if (i != params.size() - 1) {
                     final_code += ", ";
                 }
@@ -236,7 +204,7 @@ void CodeGenerator::run() {
     }
     final_code += "\n";
 
-    std::string generated_body = generate_code(ast.get_root());
+    std::string generated_body = generate_code(program);
     final_code += generated_body;
 
     std::ofstream out_file(out_address);
@@ -249,20 +217,21 @@ void CodeGenerator::run() {
     }
 }
 
-std::string CodeGenerator::generate_function(Node<Symbol> *node) {
-    auto children = node->get_children();
-    std::string func_name = children[1]->get_data().get_content();
+std::string CodeGenerator::generate_function(FuncDecl *func) {
+    // a specialization has the name of its parameter types
+    std::string func_name = symbol_table[func->symbol].get_name();
     current_func = func_name;
+    locals = &symbol_table.get_locals(func->symbol);
 
-    semantic_type return_type = symbol_table[""][func_name].get_stype();
+    type_id return_type = symbol_table[func->symbol].get_stype();
     // Special case for main, which often returns int in C
     std::string c_return_type = (func_name == "main") ? "void" : to_c_type(return_type);
 
     std::string code = c_return_type + " " + func_name + "(";
 
-    const auto &params = symbol_table[""][func_name].get_parameters();
+    const auto &params = symbol_table[func->symbol].get_parameters();
     for (size_t i = 0; i < params.size(); ++i) {
-        code += to_c_type(params[i].second) + " " + params[i].first;
+        code += to_c_declaration(params[i].second, params[i].first);
         if (i != params.size() - 1) {
             code += ", ";
         }
@@ -270,197 +239,143 @@ std::string CodeGenerator::generate_function(Node<Symbol> *node) {
 
     code += ") {\n";
 
-    // Function body is child 6 (<stmt_ls>) in your grammar `T_Fn T_Id T_LP <func_args> T_RP <func_type> T_LC <stmt_ls> <return_stmt> T_RC`
-    if (children.size() > 7) {
-        code += generate_code(children[7]);
-    }
+    code += generate_code(func->body);
 
     // Return statement
-    if (children.size() > 8 && !children[8]->get_children().empty() &&
-        children[8]->get_children()[0]->get_data().get_name() != "eps") {
-        code += generate_code(children[8]);
+    if (func->ret != nullptr) {
+        code += "\treturn " + generate_expression(func->ret) + ";\n";
     } else if (func_name == "main" && c_return_type == "int") {
         code += "\treturn 0;\n";
     }
 
     code += "}\n\n";
     current_func = "";
+    locals = &symbol_table;
+    return code;
+}
+
+// Operators are resolved in the AST, so parentheses are only emitted where C precedence needs them.
+std::string CodeGenerator::generate_operand(Expr *operand, int parent_precedence, bool right) {
+    std::string code = generate_expression(operand);
+    if (operand != nullptr && operand->kind == AST_BINARY && !folded(operand)) {
+        int precedence = ast_op_precedence[static_cast<Binary *>(operand)->op];
+        if (precedence < parent_precedence || (right && precedence == parent_precedence)) {
+            code = "(" + code + ")";
+        }
+    }
     return code;
 }
 
+// Scalars computed by semantic analysis replace the expressions, literals are kept as written.
+bool CodeGenerator::folded(Expr *exp) {
+    return exp->kind != AST_LITERAL && (exp->constant.kind == CONST_INT || exp->constant.kind == CONST_BOOL);
+}
+
+std::string CodeGenerator::generate_constant(const ConstValue &constant, type_id type) {
+    if (constant.kind == CONST_ARRAY || constant.kind == CONST_TUPLE) {
+        const TypeInfo &info = types[type];
+        std::string code = constant.kind == CONST_TUPLE ? "(" + to_c_type(type) + "){" : "{";
+        for (size_t i = 0; i < constant.elements.size(); i++) {
+            type_id element = constant.kind == CONST_ARRAY ? info.element
+                              : i < info.elements.size() ? info.elements[i] : (type_id) UNK;
+            code += (i ? ", " : "") + generate_constant(constant.elements[i], element);
+        }
+        return code + "}";
+    }
+    if (constant.kind == CONST_BOOL) {
+        return constant.number ? "true" : "false";
+    }
+    // -2147483648 would be the negation of a literal that doesn't fit in an int
+    if (constant.number == INT32_MIN) {
+        return "(-2147483647 - 1)";
+    }
+    return std::to_string(constant.number);
+}
 
-std::string CodeGenerator::generate_expression(Node<Symbol> *node) {
-    if (!node) return "";
+std::string CodeGenerator::generate_expression(Expr *exp) {
+    if (exp == nullptr) return "";
+    if (folded(exp)) {
+        return generate_constant(exp->constant, exp->type);
+    }
 
-    std::string head_name = node->get_data().get_name();
-    auto children = node->get_children();
     std::string code;
 
-    if (head_name == "arith_factor") {
-        std::string factor_type = children[0]->get_data().get_name();
-        if (factor_type == "T_Id") {
-            if (children.size() > 1 && !children[1]->get_children().empty()) {
-                if (children[1]->get_children()[0]->get_data().get_name() == "T_LP") {
-                    code = generate_function_call(node);
-                } else if (children[1]->get_children()[0]->get_data().get_name() == "T_LB") {
-                    code = generate_array_access(node);
-                } else {
-                    code = generate_code(children[0]);
+    switch (exp->kind) {
+        case AST_BINARY: {
+            auto *binary = static_cast<Binary *>(exp);
+            int precedence = ast_op_precedence[binary->op];
+            code = generate_operand(binary->lhs, precedence, false)
+                   + " " + ast_op_to_string[binary->op] + " "
+                   + generate_operand(binary->rhs, precedence, true);
+            break;
+        }
+        case AST_UNARY: {
+            auto *unary = static_cast<Unary *>(exp);
+            code = ast_op_to_string[unary->op] + generate_operand(unary->operand, ast_op_precedence[unary->op], true);
+            break;
+        }
+        case AST_LITERAL: {
+            auto *literal = static_cast<Literal *>(exp);
+            if (literal->token == T_String) {
+                std::string content = literal->text;
+                size_t pos = 0;
+                while ((pos = content.find('\"', pos)) != std::string::npos) {
+                    content.replace(pos, 1, "\\\"");
+                    pos += 2;
                 }
+                code = "\"" + content + "\"";
             } else {
-                code = generate_code(children[0]);
+                code = literal->text;
             }
-        } else if (factor_type == "T_LP") {
-            if (children[1]->get_children().size() > 1 &&
-                children[1]->get_children()[1]->get_data().get_name() == "T_Comma") {
-                code = generate_tuple_access(node);
-            } else {
-                code = "(" + generate_code(children[1]) + ")";
-            }
-        } else if (factor_type == "T_LOp_NOT") {
-            code = "!" + generate_code(children[1]);
-        } else if (factor_type == "T_AOp_MN") {
-            code = "-" + generate_expression(children[1]);
-        } else {
-            code = generate_code(children[0]);
-        }
-    } else if (head_name == "log_exp") {
-        code = generate_code(children[0]);
-        Node<Symbol> *tail = children[1];
-        while (tail && !tail->get_children().empty() && tail->get_children()[0]->get_data().get_name() != "eps") {
-            code += " || " + generate_code(tail->get_children()[1]);
-            tail = tail->get_children()[2];
-        }
-    } else if (head_name == "rel_exp") {
-        code = generate_code(children[0]);
-        Node<Symbol> *tail = children[1];
-        while (tail && !tail->get_children().empty() && tail->get_children()[0]->get_data().get_name() != "eps") {
-            code += " && " + generate_code(tail->get_children()[1]);
-            tail = tail->get_children()[2];
-        }
-    } else if (head_name == "eq_exp") {
-        code = generate_code(children[0]);
-        Node<Symbol> *tail = children[1];
-        while (tail && !tail->get_children().empty() && tail->get_children()[0]->get_data().get_name() != "eps") {
-            std::string op = tail->get_children()[0]->get_data().get_name();
-            if (op == "T_ROp_E") op = " == ";
-            else if (op == "T_ROp_NE") op = " != ";
-            code += op + generate_code(tail->get_children()[1]);
-            tail = tail->get_children()[2];
+            break;
         }
-    } else if (head_name == "cmp_exp") {
-        code = generate_code(children[0]);
-        if (children.size() > 1 && !children[1]->get_children().empty() &&
-            children[1]->get_children()[0]->get_data().get_name() != "eps") {
-            Node<Symbol> *op_node = children[1]->get_children()[0]->get_children()[0];
-            std::string op = op_node->get_data().get_name();
-            if (op == "T_ROp_L") op = " < ";
-            else if (op == "T_ROp_LE") op = " <= ";
-            else if (op == "T_ROp_G") op = " > ";
-            else if (op == "T_ROp_GE") op = " >= ";
-            code += op + generate_code(children[1]->get_children()[1]);
+        case AST_NAME:
+            code = static_cast<Name *>(exp)->name;
+            break;
+        case AST_CALL: {
+            auto *call = static_cast<Call *>(exp);
+            std::string name = call->symbol >= 0 ? symbol_table[call->symbol].get_name() : call->name;
+            code = name + "(" + generate_exp_ls(call->args) + ")";
+            break;
         }
-    } else if (head_name == "arith_exp" || head_name == "arith_term") {
-        code = generate_code(children[0]);
-        Node<Symbol> *tail = children[1];
-        while (tail && !tail->get_children().empty() && tail->get_children()[0]->get_data().get_name() != "eps") {
-            std::string op = tail->get_children()[0]->get_data().get_name();
-            if (op == "T_AOp_Trust") op = " + ";
-            else if (op == "T_AOp_MN") op = " - ";
-            else if (op == "T_AOp_ML") op = " * ";
-            else if (op == "T_AOp_DV") op = " / ";
-            else if (op == "T_AOp_RM") op = " % ";
-            code += op + generate_code(tail->get_children()[1]);
-            tail = tail->get_children()[2];
-        }
-    } else if (head_name == "exp_ls" || head_name == "pure_exp_ls") {
-        if (!children.empty() && children[0]->get_data().get_name() != "eps") {
-            code += generate_code(children[0]);
-            Node<Symbol> *tail = children[1];
-            while (tail && !tail->get_children().empty() && tail->get_children()[0]->get_data().get_name() != "eps") {
-                code += ", " + generate_code(tail->get_children()[1]);
-                tail = tail->get_children()[2];
-            }
-        }
-    } else if (!children.empty()) {
-        code = generate_code(children[0]);
+        case AST_INDEX:
+            code = static_cast<Index *>(exp)->name + "[" + generate_expression(static_cast<Index *>(exp)->index) + "]";
+            break;
+        case AST_TUPLE_LIT:
+            code = "(" + to_c_type(exp->type) + "){" + generate_exp_ls(static_cast<TupleLit *>(exp)->elements) + "}";
+            break;
+        case AST_ARRAY_LIT:
+            code = "{" + generate_exp_ls(static_cast<ArrayLit *>(exp)->elements) + "}";
+            break;
+        case AST_NAMED_ARG:
+            code = generate_expression(static_cast<NamedArg *>(exp)->value);
+            break;
+        default:
+            break;
     }
 
     return code;
 }
 
-std::string CodeGenerator::generate_function_call(Node<Symbol> *node) {
-    auto children = node->get_children(); // factor -> T_Id fac_id_opt
-    std::string func_name = children[0]->get_data().get_content();
-
-    std::string code = func_name + "(";
-
-    // fac_id_opt -> T_LP <exp_ls_call> T_RP
-    Node<Symbol> *exp_ls_call_node = children[1]->get_children()[1];
-    if (!exp_ls_call_node->get_children().empty() &&
-        exp_ls_call_node->get_children()[0]->get_data().get_name() != "eps") {
-        code += generate_expression(exp_ls_call_node->get_children()[0]);
+std::string CodeGenerator::generate_exp_ls(const std::vector<Expr *> &exps) {
+    std::string code;
+    for (size_t i = 0; i < exps.size(); ++i) {
+        code += (i ? ", " : "") + generate_expression(exps[i]);
     }
-
-    code += ")";
     return code;
 }
 
-std::string CodeGenerator::generate_array_access(Node<Symbol> *node) {
-    auto children = node->get_children();
-    std::string array_name = children[0]->get_data().get_content();
-    // fac_id_opt -> T_LB <exp> T_RB
-    std::string index = generate_expression(children[1]->get_children()[1]);
-
-    return array_name + "[" + index + "]";
-}
-
-std::string CodeGenerator::generate_tuple_access(Node<Symbol> *node) {
-    // fac_lparen -> <exp> <lpar_exp_suf>
-    // lpar_exp_suf -> T_Comma <pure_exp_ls> T_RP
-    auto children = node->get_children();
-    std::string code = "(struct tuple){";
-    code += generate_expression(children[0]); // first expression
-
-    Node<Symbol> *pure_exp_ls_node = children[1]->get_children()[1]; // <pure_exp_ls>
-    if (!pure_exp_ls_node->get_children().empty() &&
-        pure_exp_ls_node->get_children()[0]->get_data().get_name() != "eps") {
-        code += ", " + generate_expression(pure_exp_ls_node);
-    }
-
-    code += "}";
-    return code;
-}
-
-std::string CodeGenerator::generate_println(Node<Symbol> *node) {
-    auto children = node->get_children(); // println_stmt -> T_Print T_LP <println_args> T_RP T_Semicolon
-    Node<Symbol> *args_node = children[2];
+std::string CodeGenerator::generate_println(Println *println) {
     std::string code;
 
-    if (args_node->get_children().empty()) {
+    if (println->args.empty() && !println->has_format) {
         return "\tprintf(\"\\n\");\n";
     }
 
-    if (args_node->get_children()[0]->get_data().get_name() == "T_String") {
-        std::string format_str = args_node->get_children()[0]->get_data().get_content();
+    if (println->has_format) {
+        std::string format_str = println->format;
         std::string final_args_str;
-
-        std::vector<Node<Symbol> *> arg_expressions;
-        if (args_node->get_children().size() > 1 && !args_node->get_children()[1]->get_children().empty() &&
-            args_node->get_children()[1]->get_children()[0]->get_data().get_name() != "eps") {
-
-            Node<Symbol> *list_node = args_node->get_children()[1]->get_children()[1]; // <println_format_args_list>
-            if (list_node && !list_node->get_children().empty()) {
-                arg_expressions.push_back(list_node->get_children()[0]);
-
-                Node<Symbol> *tail_node = list_node->get_children()[1];
-                while (tail_node && !tail_node->get_children().empty() &&
-                       tail_node->get_children()[0]->get_data().get_name() != "eps") {
-                    arg_expressions.push_back(tail_node->get_children()[1]); // آیتم بعدی
-                    tail_node = tail_node->get_children()[2]; // tail بعدی
-                }
-            }
-        }
+        const std::vector<Expr *> &arg_expressions = println->args;
 
         size_t current_pos = 0;
         size_t sequential_arg_idx = 0;
@@ -495,54 +410,33 @@ std::string CodeGenerator::generate_println(Node<Symbol> *node) {
         code = "\tprintf(\"" + format_str + "\\n\"" + final_args_str + ");\n";
 
     } else {
-        code = "\tprintf(\"%d\\n\", " + generate_expression(args_node->get_children()[0]) + ");\n";
+        code = "\tprintf(\"%d\\n\", " + generate_expression(println->args[0]) + ");\n";
     }
 
     return code;
 }
 
-std::string CodeGenerator::generate_control_structures(Node<Symbol> *node) {
-    std::string head_name = node->get_data().get_name();
-    auto children = node->get_children();
-    std::string code;
-
-    if (head_name == "if_stmt") {
-        code = "\tif (" + generate_expression(children[1]) + ") {\n";
-
-        code += indent_block(generate_code(children[3]));
+std::string CodeGenerator::generate_if(If *if_stmt) {
+    std::string code = "\tif (" + generate_expression(if_stmt->cond) + ") {\n";
 
-        Node<Symbol> *else_opt_node = (children.size() > 5) ? children[5] : nullptr;
-        if (else_opt_node && !else_opt_node->get_children().empty() &&
-            else_opt_node->get_children()[0]->get_data().get_name() != "eps") {
-            Node<Symbol> *else_alternative_node = else_opt_node->get_children()[1];
+    code += indent_block(generate_code(if_stmt->then_block));
 
-            if (else_alternative_node->get_children()[0]->get_data().get_name() == "if_stmt") {
+    AstNode *else_branch = if_stmt->else_branch;
+    if (else_branch != nullptr && else_branch->kind == AST_IF) {
+        code += "\t} else ";
 
-                code += "\t} else ";
-
-                std::string else_if_block = generate_code(else_alternative_node->get_children()[0]);
-                if (!else_if_block.empty() && else_if_block[0] == '\t') {
-                    else_if_block.erase(0, 1);
-                }
-                code += else_if_block;
-
-            } else {
-                code += "\t} else {\n";
-                code += indent_block(generate_code(else_alternative_node->get_children()[1]));
-                code += "\t}\n";
-            }
-        } else {
-            code += "\t}\n";
+        std::string else_if_block = generate_if(static_cast<If *>(else_branch));
+        if (!else_if_block.empty() && else_if_block[0] == '\t') {
+            else_if_block.erase(0, 1);
         }
-    } else if (head_name == "loop_stmt") {
-        code = "\twhile (1) {\n";
-        code += generate_code(children[2]);
+        code += else_if_block;
+    } else if (else_branch != nullptr) {
+        code += "\t} else {\n";
+        code += indent_block(generate_code(else_branch));
+        code += "\t}\n";
+    } else {
         code += "\t}\n";
-    } else if (head_name == "break_stmt") {
-        code = "\tbreak;\n";
-    } else if (head_name == "continue_stmt") {
-        code = "\tcontinue;\n";
     }
 
     return code;
-}
\ No newline at end of file
+}
@@ -10,44 +10,47 @@
 
 class CodeGenerator {
 private:
-    Tree<Symbol> ast;
+    Program *program;
     std::string out_address;
-    std::map<std::string, std::map<std::string, SymbolTableEntry>> symbol_table;
+    const SymbolTable &symbol_table;
+    const TypeTable &types;
+    const SymbolTable *locals;
     std::string current_func;
     std::set<std::string> included_headers;
     int temp_var_counter;
 
     // Helper functions
-    std::string to_c_type(semantic_type stype);
+    std::string to_c_type(type_id type);
 
-    std::string to_c_type(const std::vector<semantic_type> &types);
+    std::string to_c_declaration(type_id type, const std::string &name);
+
+    std::string to_c_definition(type_id tuple);
 
     std::string indent_block(const std::string &block_code);
 
-    // Main generation functions
-    std::string generate_code(Node<Symbol> *node);
+    std::string generate_operand(Expr *operand, int parent_precedence, bool right);
 
-    std::string generate_function(Node<Symbol> *node);
+    bool folded(Expr *exp);
 
-    std::string generate_variable_declaration(Node<Symbol> *node);
+    std::string generate_constant(const ConstValue &constant, type_id type);
 
-    std::string generate_expression(Node<Symbol> *node);
+    // Main generation functions
+    std::string generate_code(AstNode *node);
 
-    std::string generate_println(Node<Symbol> *node);
+    std::string generate_function(FuncDecl *func);
 
-    std::string generate_control_structures(Node<Symbol> *node);
+    std::string generate_variable_declaration(Let *let);
 
-    std::string generate_function_call(Node<Symbol> *node);
+    std::string generate_expression(Expr *exp);
 
-    std::string generate_array_access(Node<Symbol> *node);
+    std::string generate_exp_ls(const std::vector<Expr *> &exps);
 
-    std::string generate_tuple_access(Node<Symbol> *node);
+    std::string generate_println(Println *println);
 
-    std::string generate_assignment_or_call_statement(Node<Symbol> *stmt_node);
+    std::string generate_if(If *if_stmt);
 
 public:
-    CodeGenerator(Tree<Symbol> _ast,
-                  std::map<std::string, std::map<std::string, SymbolTableEntry>> _symbol_table,
+    CodeGenerator(Program *_program, const SymbolTable &_symbol_table, const TypeTable &_types,
                   std::string output_file_name);
 
     void run();
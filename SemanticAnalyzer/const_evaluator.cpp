@@ -0,0 +1,354 @@
+#include "const_evaluator.h"
+
+// i32 arithmetic wraps around, as with Rust's wrapping operations
+int32_t wrap_i32(int64_t value) {
+    return (int32_t) (uint32_t) (uint64_t) value;
+}
+
+ConstValue fold_literal(Literal *literal) {
+    if (literal->token == T_True || literal->token == T_False) {
+        return ConstValue::of_bool(literal->token == T_True);
+    }
+    if (literal->token == T_Hexadecimal) {
+        return ConstValue::of_int(wrap_i32((int64_t) std::strtoull(literal->text.c_str() + 2, nullptr, 16)));
+    }
+    return ConstValue::of_int(wrap_i32((int64_t) std::strtoull(literal->text.c_str(), nullptr, 10)));
+}
+
+// Folds an operator over known operands, division by zero stays unknown and is reported by the caller.
+ConstValue fold_binary(ast_op op, const ConstValue &lhs, const ConstValue &rhs) {
+    switch (op) {
+        case OP_OR:
+        case OP_AND:
+            if (lhs.kind != CONST_BOOL || rhs.kind != CONST_BOOL) {
+                return {};
+            }
+            return ConstValue::of_bool(op == OP_OR ? lhs.number || rhs.number : lhs.number && rhs.number);
+        case OP_EQ:
+        case OP_NE:
+            if (!lhs.known() || lhs.kind != rhs.kind) {
+                return {};
+            }
+            return ConstValue::of_bool((lhs == rhs) == (op == OP_EQ));
+        default:
+            break;
+    }
+    if (lhs.kind != CONST_INT || rhs.kind != CONST_INT) {
+        return {};
+    }
+    int64_t left = lhs.number, right = rhs.number;
+    switch (op) {
+        case OP_LT:
+            return ConstValue::of_bool(left < right);
+        case OP_LE:
+            return ConstValue::of_bool(left <= right);
+        case OP_GT:
+            return ConstValue::of_bool(left > right);
+        case OP_GE:
+            return ConstValue::of_bool(left >= right);
+        case OP_ADD:
+            return ConstValue::of_int(wrap_i32(left + right));
+        case OP_SUB:
+            return ConstValue::of_int(wrap_i32(left - right));
+        case OP_MUL:
+            return ConstValue::of_int(wrap_i32(left * right));
+        case OP_DIV:
+            return right == 0 ? ConstValue() : ConstValue::of_int(wrap_i32(left / right));
+        case OP_REM:
+            return right == 0 ? ConstValue() : ConstValue::of_int(wrap_i32(left % right));
+        default:
+            return {};
+    }
+}
+
+void ConstEvaluator::add_function(FuncDecl *func) {
+    functions.emplace(func->name, func);
+}
+
+// A function is pure until it is found to print or to call an unknown or impure function.
+void ConstEvaluator::mark_pure_functions() {
+    std::map<FuncDecl *, std::set<std::string>> callees;
+    for (const auto &function: functions) {
+        FuncDecl *func = function.second;
+        bool prints = false;
+        std::vector<AstNode *> stack = {func->body, func->ret};
+        while (!stack.empty()) {
+            AstNode *node = stack.back();
+            stack.pop_back();
+            if (node == nullptr) {
+                continue;
+            }
+            if (node->kind == AST_PRINTLN) {
+                prints = true;
+                break;
+            }
+            if (node->kind == AST_CALL) {
+                callees[func].insert(static_cast<Call *>(node)->name);
+            }
+            get_ast_children(node, stack);
+        }
+        if (!prints) {
+            pure.insert(func);
+        }
+    }
+
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (auto it = pure.begin(); it != pure.end();) {
+            bool calls_impure = false;
+            for (const auto &name: callees[*it]) {
+                auto callee = functions.find(name);
+                calls_impure = calls_impure || callee == functions.end() || !pure.count(callee->second);
+            }
+            if (calls_impure) {
+                it = pure.erase(it);
+                changed = true;
+            } else {
+                ++it;
+            }
+        }
+    }
+}
+
+bool ConstEvaluator::is_pure(const std::string &name) const {
+    auto function = functions.find(name);
+    return function != functions.end() && pure.count(function->second);
+}
+
+ConstValue ConstEvaluator::call(const std::string &name, const std::vector<ConstValue> &args) const {
+    EvalState state;
+    ConstValue value = invoke(name, args, state);
+    return state.failed ? ConstValue() : value;
+}
+
+bool ConstEvaluator::step(EvalState &state) const {
+    if (++state.steps > CONST_EVAL_MAX_STEPS) {
+        state.failed = true;
+    }
+    return !state.failed;
+}
+
+ConstValue *ConstEvaluator::lookup(const std::string &name, Frame &frame) const {
+    for (auto scope = frame.rbegin(); scope != frame.rend(); ++scope) {
+        auto binding = scope->find(name);
+        if (binding != scope->end()) {
+            return &binding->second;
+        }
+    }
+    return nullptr;
+}
+
+ConstValue ConstEvaluator::invoke(const std::string &name, const std::vector<ConstValue> &args,
+                                  EvalState &state) const {
+    auto function = functions.find(name);
+    if (function == functions.end() || !pure.count(function->second) || state.depth >= CONST_EVAL_MAX_DEPTH ||
+        function->second->params.size() != args.size()) {
+        state.failed = true;
+        return {};
+    }
+    FuncDecl *func = function->second;
+
+    Frame frame(1);
+    for (size_t i = 0; i < args.size(); i++) {
+        frame[0][func->params[i]->name] = args[i];
+    }
+    state.depth++;
+    ConstValue value;
+    if (execute(func->body, frame, state) != FLOW_FAIL && func->ret != nullptr) {
+        value = evaluate(func->ret, frame, state);
+    }
+    state.depth--;
+    return value;
+}
+
+eval_flow ConstEvaluator::execute_scoped(AstNode *node, Frame &frame, EvalState &state) const {
+    frame.emplace_back();
+    eval_flow flow = execute(node, frame, state);
+    frame.pop_back();
+    return flow;
+}
+
+eval_flow ConstEvaluator::execute(AstNode *node, Frame &frame, EvalState &state) const {
+    if (node == nullptr) {
+        return FLOW_NEXT;
+    }
+    if (!step(state)) {
+        return FLOW_FAIL;
+    }
+
+    switch (node->kind) {
+        case AST_BLOCK:
+            for (auto stmt: static_cast<Block *>(node)->stmts) {
+                eval_flow flow = execute(stmt, frame, state);
+                if (flow != FLOW_NEXT) {
+                    return flow;
+                }
+            }
+            return FLOW_NEXT;
+        case AST_LET: {
+            auto *let = static_cast<Let *>(node);
+            ConstValue value;
+            if (let->init != nullptr) {
+                value = evaluate(let->init, frame, state);
+                if (state.failed) {
+                    return FLOW_FAIL;
+                }
+            }
+            if (!let->tuple_pattern) {
+                frame.back()[let->names[0]] = value;
+            } else if (value.kind == CONST_TUPLE && value.elements.size() == let->names.size()) {
+                for (size_t i = 0; i < let->names.size(); i++) {
+                    frame.back()[let->names[i]] = value.elements[i];
+                }
+            } else if (let->init == nullptr) {
+                for (const auto &name: let->names) {
+                    frame.back()[name] = ConstValue();
+                }
+            } else {
+                return FLOW_FAIL;
+            }
+            return FLOW_NEXT;
+        }
+        case AST_ASSIGN: {
+            auto *assign = static_cast<Assign *>(node);
+            ConstValue value = evaluate(assign->value, frame, state);
+            ConstValue *variable = lookup(assign->name, frame);
+            if (state.failed || variable == nullptr) {
+                return FLOW_FAIL;
+            }
+            *variable = value;
+            return FLOW_NEXT;
+        }
+        case AST_INDEX_ASSIGN: {
+            auto *assign = static_cast<IndexAssign *>(node);
+            ConstValue index = evaluate(assign->index, frame, state);
+            ConstValue value = evaluate(assign->value, frame, state);
+            ConstValue *array = lookup(assign->name, frame);
+            if (state.failed || array == nullptr || array->kind != CONST_ARRAY || index.kind != CONST_INT ||
+                index.number < 0 || index.number >= (int32_t) array->elements.size()) {
+                return FLOW_FAIL;
+            }
+            array->elements[index.number] = value;
+            return FLOW_NEXT;
+        }
+        case AST_CALL_STMT: {
+            auto *call = static_cast<CallStmt *>(node)->call;
+            std::vector<ConstValue> args;
+            for (auto arg: call->args) {
+                args.push_back(evaluate(arg, frame, state));
+            }
+            if (!state.failed) {
+                invoke(call->name, args, state);
+            }
+            return state.failed ? FLOW_FAIL : FLOW_NEXT;
+        }
+        case AST_IF: {
+            auto *if_stmt = static_cast<If *>(node);
+            ConstValue cond = evaluate(if_stmt->cond, frame, state);
+            if (cond.kind != CONST_BOOL) {
+                return FLOW_FAIL;
+            }
+            return execute_scoped(cond.number ? if_stmt->then_block : if_stmt->else_branch, frame, state);
+        }
+        case AST_LOOP:
+            while (true) {
+                eval_flow flow = execute_scoped(static_cast<Loop *>(node)->body, frame, state);
+                if (flow == FLOW_BREAK) {
+                    return FLOW_NEXT;
+                }
+                if (flow == FLOW_FAIL || !step(state)) {
+                    return FLOW_FAIL;
+                }
+            }
+        case AST_BREAK:
+            return FLOW_BREAK;
+        case AST_CONTINUE:
+            return FLOW_CONTINUE;
+        default:
+            // println, the only side effect
+            return FLOW_FAIL;
+    }
+}
+
+ConstValue ConstEvaluator::evaluate(Expr *exp, Frame &frame, EvalState &state) const {
+    if (exp == nullptr || !step(state)) {
+        state.failed = true;
+        return {};
+    }
+
+    ConstValue value;
+    switch (exp->kind) {
+        case AST_LITERAL:
+            if (static_cast<Literal *>(exp)->token != T_String) {
+                value = fold_literal(static_cast<Literal *>(exp));
+            }
+            break;
+        case AST_NAME: {
+            ConstValue *variable = lookup(static_cast<Name *>(exp)->name, frame);
+            if (variable != nullptr) {
+                value = *variable;
+            }
+            break;
+        }
+        case AST_CALL: {
+            auto *call = static_cast<Call *>(exp);
+            std::vector<ConstValue> args;
+            for (auto arg: call->args) {
+                args.push_back(evaluate(arg, frame, state));
+            }
+            if (!state.failed) {
+                value = invoke(call->name, args, state);
+            }
+            break;
+        }
+        case AST_INDEX: {
+            auto *index = static_cast<Index *>(exp);
+            ConstValue position = evaluate(index->index, frame, state);
+            ConstValue *array = lookup(index->name, frame);
+            if (array != nullptr && array->kind == CONST_ARRAY && position.kind == CONST_INT &&
+                position.number >= 0 && position.number < (int32_t) array->elements.size()) {
+                value = array->elements[position.number];
+            }
+            break;
+        }
+        case AST_BINARY: {
+            auto *binary = static_cast<Binary *>(exp);
+            ConstValue lhs = evaluate(binary->lhs, frame, state);
+            // && and || don't evaluate the right operand once the left one decides
+            if ((binary->op == OP_AND || binary->op == OP_OR) && lhs.kind == CONST_BOOL &&
+                (bool) lhs.number == (binary->op == OP_OR)) {
+                value = lhs;
+            } else {
+                value = fold_binary(binary->op, lhs, evaluate(binary->rhs, frame, state));
+            }
+            break;
+        }
+        case AST_UNARY: {
+            auto *unary = static_cast<Unary *>(exp);
+            ConstValue operand = evaluate(unary->operand, frame, state);
+            if (unary->op == OP_NOT && operand.kind == CONST_BOOL) {
+                value = ConstValue::of_bool(!operand.number);
+            } else if (unary->op == OP_NEG && operand.kind == CONST_INT) {
+                value = ConstValue::of_int(wrap_i32(-(int64_t) operand.number));
+            }
+            break;
+        }
+        case AST_TUPLE_LIT:
+        case AST_ARRAY_LIT: {
+            const std::vector<Expr *> &elements = exp->kind == AST_TUPLE_LIT ? static_cast<TupleLit *>(exp)->elements
+                                                                            : static_cast<ArrayLit *>(exp)->elements;
+            value.kind = exp->kind == AST_TUPLE_LIT ? CONST_TUPLE : CONST_ARRAY;
+            for (auto element: elements) {
+                value.elements.push_back(evaluate(element, frame, state));
+            }
+            break;
+        }
+        default:
+            break;
+    }
+
+    if (!value.known()) {
+        state.failed = true;
+    }
+    return value;
+}
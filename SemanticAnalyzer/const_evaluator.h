@@ -0,0 +1,72 @@
+#ifndef CONST_EVALUATOR_H
+#define CONST_EVALUATOR_H
+
+#include <map>
+#include <set>
+
+#include "../utils.h"
+#include "../SyntaxAnalyzer/ast.h"
+
+#define CONST_EVAL_MAX_STEPS 100000
+#define CONST_EVAL_MAX_DEPTH 64
+
+int32_t wrap_i32(int64_t value);
+
+ConstValue fold_literal(Literal *literal);
+
+ConstValue fold_binary(ast_op op, const ConstValue &lhs, const ConstValue &rhs);
+
+// how a statement finished
+enum eval_flow {
+    FLOW_NEXT,
+    FLOW_BREAK,
+    FLOW_CONTINUE,
+    FLOW_FAIL
+};
+
+// one compile-time call, the budget is shared by everything it calls
+struct EvalState {
+    long steps = 0;
+    int depth = 0;
+    bool failed = false;
+};
+
+/*
+    Runs calls of pure functions, the ones that neither print nor call a function that does,
+    on constant arguments. The evaluator only reads the names, operators and literals of the
+    AST, never the annotations, so a call can be run while the callee's body is still being
+    checked on another thread. A call that prints, divides by zero, indexes out of bounds or
+    runs out of steps or depth has no value and is left for run time.
+*/
+class ConstEvaluator {
+private:
+    typedef std::vector<std::map<std::string, ConstValue>> Frame;
+
+    std::map<std::string, FuncDecl *> functions;
+    std::set<FuncDecl *> pure;
+
+    bool step(EvalState &state) const;
+
+    ConstValue *lookup(const std::string &name, Frame &frame) const;
+
+    ConstValue invoke(const std::string &name, const std::vector<ConstValue> &args, EvalState &state) const;
+
+    eval_flow execute(AstNode *node, Frame &frame, EvalState &state) const;
+
+    eval_flow execute_scoped(AstNode *node, Frame &frame, EvalState &state) const;
+
+    ConstValue evaluate(Expr *exp, Frame &frame, EvalState &state) const;
+
+public:
+    // the first declaration of a name is the one calls resolve to
+    void add_function(FuncDecl *func);
+
+    void mark_pure_functions();
+
+    bool is_pure(const std::string &name) const;
+
+    // the value of the call, unknown if it can't be computed within the budget
+    ConstValue call(const std::string &name, const std::vector<ConstValue> &args) const;
+};
+
+#endif // CONST_EVALUATOR_H
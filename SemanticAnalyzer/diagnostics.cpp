@@ -0,0 +1,193 @@
+#include "diagnostics.h"
+
+#include <climits>
+#include <unordered_map>
+
+const DiagnosticInfo diagnostic_info[DIAG_COUNT] = {
+        {"undeclared-identifier", "Use of undeclared identifier '{0}'.",
+         {"The identifier must be declared before it is used.",
+          "Check for missing declarations or typos in the name."}, true},
+        {"missing-return", "Function '{0}' declared to return type '{1}' but has no return statement.",
+         {"Ensure the function returns a value of the declared type or change the return type to 'void'."}, false},
+        {"return-inference", "Unable to infer return type for function '{0}' from the return expression.",
+         {"The expression has an unsupported or unknown type.",
+          "Ensure the expression is valid and has a type like int, bool, array, or tuple."}, false},
+        {"return-type", "Function '{0}' declared to return type '{1}' but has a return statement of type '{2}'.",
+         {"Ensure the function returns a value of the declared type."}, false},
+        {"variable-type", "Type mismatch for variable '{0}'.",
+         {"Expected type '{1}' but got type '{2}'.",
+          "Ensure the assigned value matches the variable's declared type."}, false},
+        {"redefinition", "Identifier '{0}' is already defined in this scope.", {}, false},
+        {"tuple-declaration", "Mismatch in tuple declaration for identifier '{0}'.",
+         {"Declared {1} variable(s) but provided {2} type(s).",
+          "Ensure the number of variables matches the number of types in the tuple."}, false},
+        {"tuple-assignment", "Mismatch in tuple assignment for identifier '{0}'.",
+         {"Assigned {1} value(s) but expected {2}.",
+          "Ensure the number of assigned values matches the number of variables in the tuple."}, false},
+        {"variable-inference", "Unable to infer type for variable '{0}' from the assigned expression.",
+         {"The expression has an unsupported or unknown type.",
+          "Ensure the expression is valid and has a type like int, bool, array, or tuple."}, false},
+        {"immutable-variable", "Cannot assign to immutable variable '{0}'.",
+         {"This variable was not declared as mutable (e.g., 'let mut {0}').",
+          "To allow mutation, declare the variable with the 'mut' keyword."}, true},
+        {"not-an-array", "Identifier '{0}' is not an array and cannot be indexed.", {}, true},
+        {"immutable-array", "Cannot assign to an element of immutable array '{0}'.",
+         {"To allow mutation, declare the array with 'mut'."}, true},
+        {"index-assign-type", "Array index for '{0}' must be of type 'i32'.",
+         {"The provided index has type {1}."}, false},
+        {"negative-index-assign", "Array index for assignment cannot be negative. Got: {1} for array '{0}'.", {},
+         false},
+        {"array-element-type", "Type mismatch in assignment to array '{0}'.",
+         {"Array elements have type '{1}' but assigned value has type '{2}'."}, false},
+        {"if-condition", "Condition in 'if' statement must be of type 'bool'.",
+         {"The expression used in the condition is not a boolean expression.",
+          "Ensure the condition evaluates to a boolean value (true or false)."}, false},
+        {"argument-type", "Type mismatch in arguments of call to function '{0}'.",
+         {"Expected argument {1} to be of type '{2}' but got type '{3}'."}, false},
+        {"argument-count", "Incorrect number of arguments in call to function '{0}'.",
+         {"Expected {1} argument(s), but got {2}."}, false},
+        {"index-type", "Array index for '{0}' must be of type 'i32'.",
+         {"The provided index expression is not an integer, it is {1}."}, false},
+        {"negative-index", "Array index cannot be negative. Got: {1} for array '{0}'.", {}, false},
+        {"logical-left", "Left operand of logical operator must be of type 'bool'.",
+         {"The left operand has type '{0}' which is not boolean.",
+          "Ensure the left operand is a boolean expression (true or false)."}, false},
+        {"logical-right", "Right operand of logical operator must be of type 'bool'.",
+         {"The right operand has type '{0}' which is not boolean.",
+          "Ensure the right operand is a boolean expression (true or false)."}, false},
+        {"equality-types", "Operands of equality operator must have the same type.",
+         {"Left operand has type '{0}' and right operand has type '{1}'.",
+          "Ensure both operands are of the same type for comparison."}, false},
+        {"comparison-left", "Left operand of comparison operator must be of type 'int'.",
+         {"The left operand has type '{0}' which is not integer.",
+          "Ensure the left operand is an integer expression."}, false},
+        {"comparison-right", "Right operand of comparison operator must be of type 'int'.",
+         {"The right operand has type '{0}' which is not integer.",
+          "Ensure the right operand is an integer expression."}, false},
+        {"arithmetic-left", "Left operand of arithmetic operator must be of type 'int'.",
+         {"The left operand has type '{0}' which is not integer.",
+          "Ensure the left operand is an integer expression."}, false},
+        {"arithmetic-right", "Right operand of arithmetic operator must be of type 'int'.",
+         {"The right operand has type '{0}' which is not integer.",
+          "Ensure the right operand is an integer expression."}, false},
+        {"division-by-zero", "Division by zero in a constant expression.",
+         {"The right operand of '{0}' is always 0."}, false},
+        {"not-operand", "Logical NOT operator '!' cannot be applied to a non-boolean type.",
+         {"Expected operand of type 'bool' but got '{0}'."}, false},
+        {"neg-operand", "Unary minus operator '-' cannot be applied to a non-integer type.",
+         {"Expected operand of type 'int' but got '{0}'."}, false},
+        {"no-main", "No 'main' function found.",
+         {"Every program must have a 'main' function as the entry point."}, false},
+        {"function-redeclaration", "Redeclaration of function '{0}'. Functions must have unique names globally.", {},
+         false},
+};
+
+// the template with {i} replaced by the i-th argument
+static std::string expand(const char *text, const std::vector<std::string> &args) {
+    std::string res;
+    for (const char *c = text; *c; c++) {
+        if (c[0] == '{' && c[1] >= '0' && c[1] <= '9' && c[2] == '}' && (size_t) (c[1] - '0') < args.size()) {
+            res += args[c[1] - '0'];
+            c += 2;
+        } else {
+            res += *c;
+        }
+    }
+    return res;
+}
+
+DiagnosticEngine::DiagnosticEngine() {
+    max_errors = INT_MAX;
+    format = DIAG_TEXT;
+}
+
+void DiagnosticEngine::add(std::vector<Diagnostic> diagnostics) {
+    records.insert(records.end(), std::make_move_iterator(diagnostics.begin()),
+                   std::make_move_iterator(diagnostics.end()));
+}
+
+int DiagnosticEngine::finish() {
+    // reports without a line go last, the order of reports on one line is kept
+    std::stable_sort(records.begin(), records.end(), [](const Diagnostic &a, const Diagnostic &b) {
+        return (unsigned) a.line - 1 < (unsigned) b.line - 1;
+    });
+
+    std::unordered_map<std::string, size_t> first;
+    std::vector<Diagnostic> kept;
+    for (auto &record: records) {
+        std::string key = std::to_string(record.code);
+        if (!diagnostic_info[record.code].per_name || record.args.empty()) {
+            key += " " + std::to_string(record.line);
+            for (const auto &arg: record.args) {
+                key += '\0' + arg;
+            }
+        } else {
+            key += " " + record.args[0];
+        }
+        auto found = first.find(key);
+        if (found != first.end()) {
+            kept[found->second].repeats += 1 + record.repeats;
+        } else {
+            first.emplace(std::move(key), kept.size());
+            kept.push_back(std::move(record));
+        }
+    }
+    records = std::move(kept);
+    return (int) records.size();
+}
+
+std::string DiagnosticEngine::render_text(const Diagnostic &diagnostic) const {
+    const DiagnosticInfo &info = diagnostic_info[diagnostic.code];
+    std::string text = RED + "Semantic Error";
+    if (diagnostic.line > 0) {
+        text += " [Line " + std::to_string(diagnostic.line) + "]";
+    }
+    text += ": " + expand(info.message, diagnostic.args) + "\n";
+    for (const char *note: info.notes) {
+        text += "  - " + expand(note, diagnostic.args) + "\n";
+    }
+    if (diagnostic.repeats > 0) {
+        text += "  - Reported once, it occurs " + std::to_string(diagnostic.repeats) + " more time(s) later on.\n";
+    }
+    return text + WHITE + "\n----------------------------------------------------------------\n";
+}
+
+std::string DiagnosticEngine::render_json(const Diagnostic &diagnostic) const {
+    const DiagnosticInfo &info = diagnostic_info[diagnostic.code];
+    std::string text = "{\"severity\":\"error\",\"code\":\"" + std::string(info.name) + "\"";
+    if (diagnostic.line > 0) {
+        text += ",\"line\":" + std::to_string(diagnostic.line);
+    }
+    text += ",\"message\":\"" + json_escape(expand(info.message, diagnostic.args)) + "\",\"notes\":[";
+    for (size_t i = 0; i < info.notes.size(); i++) {
+        text += (i ? ",\"" : "\"") + json_escape(expand(info.notes[i], diagnostic.args)) + "\"";
+    }
+    text += "],\"args\":[";
+    for (size_t i = 0; i < diagnostic.args.size(); i++) {
+        text += (i ? ",\"" : "\"") + json_escape(diagnostic.args[i]) + "\"";
+    }
+    return text + "],\"repeats\":" + std::to_string(diagnostic.repeats) + "}";
+}
+
+// the reports are put together in one string, so a long list is written without a flush per line
+void DiagnosticEngine::emit(std::ostream &stream) const {
+    size_t shown = std::min(records.size(), (size_t) std::max(max_errors, 0));
+    std::string text;
+    if (format == DIAG_JSON) {
+        text += "{\"diagnostics\":[";
+        for (size_t i = 0; i < shown; i++) {
+            text += (i ? ",\n" : "\n") + render_json(records[i]);
+        }
+        text += "\n],\"total\":" + std::to_string(records.size()) + ",\"shown\":" + std::to_string(shown) + "}\n";
+    } else {
+        for (size_t i = 0; i < shown; i++) {
+            text += render_text(records[i]);
+        }
+        if (shown < records.size()) {
+            text += RED + "Semantic Error: Too many errors, " + std::to_string(records.size() - shown) +
+                    " more not shown" + WHITE + "\n";
+        }
+    }
+    stream << text;
+    stream.flush();
+}
@@ -0,0 +1,92 @@
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include "../utils.h"
+
+enum diag_code {
+    DIAG_UNDECLARED_IDENTIFIER,
+    DIAG_MISSING_RETURN,
+    DIAG_RETURN_INFERENCE,
+    DIAG_RETURN_TYPE,
+    DIAG_VARIABLE_TYPE,
+    DIAG_REDEFINITION,
+    DIAG_TUPLE_DECLARATION,
+    DIAG_TUPLE_ASSIGNMENT,
+    DIAG_VARIABLE_INFERENCE,
+    DIAG_IMMUTABLE_VARIABLE,
+    DIAG_NOT_AN_ARRAY,
+    DIAG_IMMUTABLE_ARRAY,
+    DIAG_INDEX_ASSIGN_TYPE,
+    DIAG_NEGATIVE_INDEX_ASSIGN,
+    DIAG_ARRAY_ELEMENT_TYPE,
+    DIAG_IF_CONDITION,
+    DIAG_ARGUMENT_TYPE,
+    DIAG_ARGUMENT_COUNT,
+    DIAG_INDEX_TYPE,
+    DIAG_NEGATIVE_INDEX,
+    DIAG_LOGICAL_LEFT,
+    DIAG_LOGICAL_RIGHT,
+    DIAG_EQUALITY_TYPES,
+    DIAG_COMPARISON_LEFT,
+    DIAG_COMPARISON_RIGHT,
+    DIAG_ARITHMETIC_LEFT,
+    DIAG_ARITHMETIC_RIGHT,
+    DIAG_DIVISION_BY_ZERO,
+    DIAG_NOT_OPERAND,
+    DIAG_NEG_OPERAND,
+    DIAG_NO_MAIN,
+    DIAG_FUNCTION_REDECLARATION,
+    DIAG_COUNT
+};
+
+struct DiagnosticInfo {
+    const char *name;                // the code in JSON output
+    const char *message;             // {0}, {1}, ... stand for the arguments
+    std::vector<const char *> notes;
+    bool per_name;                   // reported once for each name, its first argument
+};
+
+extern const DiagnosticInfo diagnostic_info[DIAG_COUNT];
+
+enum diag_format {
+    DIAG_TEXT,
+    DIAG_JSON
+};
+
+// one report, its text is only put together when it is emitted
+struct Diagnostic {
+    diag_code code;
+    int line;  // 0 when the report isn't about a line
+    std::vector<std::string> args;
+    int repeats = 0;  // later reports folded into this one
+};
+
+/*
+    Collects the reports of every item before anything is printed. Reports of the same code
+    about the same name, such as the uses of one undeclared identifier, and identical reports
+    on one line are folded into the first one. The rest are ordered by line and written in
+    one piece, at most max_errors of them.
+*/
+class DiagnosticEngine {
+private:
+    std::vector<Diagnostic> records;
+
+    std::string render_text(const Diagnostic &diagnostic) const;
+
+    std::string render_json(const Diagnostic &diagnostic) const;
+
+public:
+    int max_errors;
+    diag_format format;
+
+    DiagnosticEngine();
+
+    void add(std::vector<Diagnostic> diagnostics);
+
+    // folds and orders the reports, the number of reports left
+    int finish();
+
+    void emit(std::ostream &stream) const;
+};
+
+#endif // DIAGNOSTICS_H
@@ -1,72 +1,8 @@
 #include "semantic_analyzer.h"
-
-std::vector<std::string> split(std::string s, std::vector<char> chs) {
-    int n = s.size();
-    std::vector<std::string> sp;
-
-    std::string tmp;
-    for (int i = 0; i < n; i++) {
-        bool f = false;
-        for (char ch: chs) {
-            if (s[i] == ch) {
-                f = true;
-                break;
-            }
-        }
-        if (!f) {
-            tmp += s[i];
-        } else if (!tmp.empty()) {
-            sp.push_back(tmp);
-            tmp = "";
-        }
-    }
-    if (!tmp.empty()) {
-        sp.push_back(tmp);
-    }
-    return sp;
-}
-
-std::string eval(std::string exp, std::vector<char> chs) {
-    if (exp.empty()) {
-        return exp;
-    }
-
-    int64_t val = 1;
-    if (exp[0] == '-') {
-        exp = exp.substr(1, exp.size() - 1);
-        val = -1;
-    }
-    std::vector<std::string> sp = split(exp, chs);
-    int len = exp.size(), j = 1;
-    int64_t result = stoi(sp[0]) * val;
-    if (chs.size() == 2) {
-        for (int i = 0; i < len; i++) {
-            if (exp[i] == '+') {
-                result += stoi(sp[j++]);
-            } else if (exp[i] == '-') {
-                result -= stoi(sp[j++]);
-            }
-        }
-    } else if (chs.size() == 3) {
-        for (int i = 0; i < len; i++) {
-            if (exp[i] == '*') {
-                result *= stoi(sp[j++]);
-            } else if (exp[i] == '/') {
-                if (stoi(sp[j]) != 0) {
-                    result /= stoi(sp[j]);
-                }
-                j++;
-            } else if (exp[i] == '%') {
-                if (stoi(sp[j]) != 0) {
-                    result %= stoi(sp[j]);
-                }
-                j++;
-            }
-        }
-    }
-
-    return std::to_string(result);
-}
+#include <atomic>
+#include <climits>
+#include <set>
+#include <thread>
 
 semantic_type exp_t_to_semantic_type(exp_type t) {
     switch (t) {
@@ -102,980 +38,991 @@ std::string exp_t_to_string(exp_type t) {
     }
 }
 
-void SemanticAnalyzer::dfs(Node<Symbol> *node) {
-    std::deque<Node<Symbol> *> children = node->get_children();
-    Symbol &symbol = node->get_data();
-    std::string head_name = symbol.get_name();
-    int line_number = symbol.get_line_number();
+exp_type semantic_type_to_exp_t(semantic_type t) {
+    switch (t) {
+        case INT:
+            return TYPE_INT;
+        case BOOL:
+            return TYPE_BOOL;
+        case ARRAY:
+            return TYPE_ARRAY;
+        case TUPLE:
+            return TYPE_TUPLE;
+        case VOID:
+            return TYPE_VOID;
+        default:
+            return TYPE_UNKNOWN;
+    }
+}
 
-    bool is_new_scope = false;
+static ConstValue fold_elements(const_kind kind, const std::vector<Expr *> &elements) {
+    ConstValue value;
+    for (auto element: elements) {
+        if (!element->constant.known()) {
+            return {};
+        }
+        value.elements.push_back(element->constant);
+    }
+    value.kind = kind;
+    return value;
+}
 
-    if (head_name == "func" || head_name == "loop_stmt" || head_name == "if_stmt" || head_name == "else_alternative") {
-        is_new_scope = true;
-        def_area++;
+void BodyChecker::dfs(AstNode *node) {
+    if (node == nullptr) {
+        return;
     }
 
-    if (head_name == "func") {
-        std::string name = children[1]->get_data().get_content();
-        current_func = name;
-        if (symbol_table[""].count(name)) {
-            std::cerr << RED << "Semantic Error [Line " << line_number << "]: "
-                      << "Redeclaration of function '" << name << "'. Functions must have unique names globally.\n"
-                      << WHITE << std::endl;
-            std::cerr << "----------------------------------------------------------------" << std::endl;
-            num_errors++;
-        }
-        symbol_table[""][name] = SymbolTableEntry(FUNC);
-        symbol_table[name];
-        Node<Symbol> *args_node = children[3];
-        if (args_node->get_children()[0]->get_data().get_name() != "eps") {
-            Node<Symbol> *arg_node = args_node->get_children()[0];
-            std::string arg_name = arg_node->get_children()[0]->get_data().get_content();
-            SymbolTableEntry arg_entry(VAR);
-            arg_entry.set_name(arg_name);
-            arg_entry.set_def_area(def_area);
-            arg_entry.set_mut(false);
-            if (arg_node->get_children()[1]->get_children()[0]->get_data().get_name() != "eps") {
-                dfs(arg_node->get_children()[1]->get_children()[1]);
-                arg_entry.set_stype(arg_node->get_children()[1]->get_children()[1]->get_data().get_stype());
+    switch (node->kind) {
+        case AST_PROGRAM:
+            for (auto item: static_cast<Program *>(node)->items) {
+                dfs(item);
+            }
+            break;
+        case AST_BLOCK:
+            for (auto stmt: static_cast<Block *>(node)->stmts) {
+                dfs(stmt);
+            }
+            break;
+        case AST_FUNC_DECL:
+            analyze_function(static_cast<FuncDecl *>(node));
+            break;
+        case AST_LET:
+            analyze_let(static_cast<Let *>(node));
+            break;
+        case AST_ASSIGN:
+            analyze_assign(static_cast<Assign *>(node));
+            break;
+        case AST_INDEX_ASSIGN:
+            analyze_index_assign(static_cast<IndexAssign *>(node));
+            break;
+        case AST_CALL_STMT:
+            analyze_call(static_cast<CallStmt *>(node)->call);
+            break;
+        case AST_IF:
+            analyze_if(static_cast<If *>(node));
+            break;
+        case AST_LOOP:
+            locals->push_scope();
+            dfs(static_cast<Loop *>(node)->body);
+            locals->pop_scope();
+            break;
+        case AST_PRINTLN:
+            for (auto arg: static_cast<Println *>(node)->args) {
+                dfs(arg);
+            }
+            break;
+        case AST_LITERAL: {
+            auto *literal = static_cast<Literal *>(node);
+            if (literal->token == T_String) {
+                literal->exp_t = TYPE_STRING;
             } else {
-                arg_entry.set_stype(UNK);
+                literal->exp_t = literal->token == T_True || literal->token == T_False ? TYPE_BOOL : TYPE_INT;
+                literal->constant = fold_literal(literal);
             }
-            symbol_table[current_func][arg_name] = arg_entry;
-            symbol_table[""][current_func].add_to_parameters({arg_name, arg_entry.get_stype()});
-            Node<Symbol> *args_tail_node = args_node->get_children()[1];
-            while (args_tail_node->get_children()[0]->get_data().get_name() != "eps") {
-                arg_node = args_tail_node->get_children()[1];
-                arg_name = arg_node->get_children()[0]->get_data().get_content();
-                SymbolTableEntry next_arg_entry(VAR);
-                next_arg_entry.set_name(arg_name);
-                next_arg_entry.set_def_area(def_area);
-                next_arg_entry.set_mut(false);
-                if (arg_node->get_children()[1]->get_children()[0]->get_data().get_name() != "eps") {
-                    dfs(arg_node->get_children()[1]->get_children()[1]);
-                    next_arg_entry.set_stype(arg_node->get_children()[1]->get_children()[1]->get_data().get_stype());
-                } else {
-                    next_arg_entry.set_stype(UNK);
-                }
-                symbol_table[current_func][arg_name] = next_arg_entry;
-                symbol_table[""][current_func].add_to_parameters({arg_name, next_arg_entry.get_stype()});
-                args_tail_node = args_tail_node->get_children()[2];
+            break;
+        }
+        case AST_NAME: {
+            auto *name = static_cast<Name *>(node);
+            check_identifier(name->name, name->line);
+            name->symbol = locals->find(name->name);
+            if (name->symbol >= 0) {
+                SymbolTableEntry &entry = (*locals)[name->symbol];
+                name->constant = entry.get_constant();
+                name->type = entry.get_stype();
+                name->exp_t = semantic_type_to_exp_t(types->kind(name->type));
             }
+            break;
         }
-    }
-
-    if (head_name == "var_declaration") {
-        // handle <pattern>
-        int children_size = children[2]->get_children().size();
-        std::vector<std::string> names;
-        if (children_size == 3) {
-            names.push_back(children[2]->get_children()[1]->get_children()[0]->get_data().get_content());
-            auto tmp_child = children[2]->get_children()[1]->get_children()[1];
-            while (tmp_child->get_children()[0]->get_data().get_name() != "eps") {
-                names.push_back(tmp_child->get_children()[1]->get_data().get_content());
-                tmp_child = tmp_child->get_children()[2];
+        case AST_CALL:
+            analyze_call(static_cast<Call *>(node));
+            break;
+        case AST_INDEX:
+            analyze_index(static_cast<Index *>(node));
+            break;
+        case AST_BINARY:
+            analyze_binary(static_cast<Binary *>(node));
+            break;
+        case AST_UNARY:
+            analyze_unary(static_cast<Unary *>(node));
+            break;
+        case AST_TUPLE_LIT: {
+            auto *tuple = static_cast<TupleLit *>(node);
+            std::vector<type_id> element_types;
+            for (auto element: tuple->elements) {
+                dfs(element);
+                element_types.push_back(element->type);
             }
-        } else {
-            names.push_back(children[2]->get_children()[0]->get_data().get_content());
-        }
-        for (const auto &name: names) {
-            if (symbol_table[current_func].count(name) && symbol_table[current_func][name].get_def_area() == def_area) {
-                std::cerr << RED << "Semantic Error [Line " << line_number << "]: "
-                          << "Identifier '" << name << "' is already defined in this scope." << WHITE << std::endl;
-                std::cerr << "----------------------------------------------------------------" << std::endl;
-                num_errors++;
-            } else {
-                SymbolTableEntry x(VAR);
-                x.set_name(name);
-                x.set_mut(children[1]->get_children()[0]->get_data().get_name() != "eps");
-                x.set_def_area(def_area);
-                symbol_table[current_func][name] = x;
+            tuple->exp_t = TYPE_TUPLE;
+            tuple->type = types->tuple(element_types);
+            tuple->constant = fold_elements(CONST_TUPLE, tuple->elements);
+            break;
+        }
+        case AST_ARRAY_LIT: {
+            auto *array = static_cast<ArrayLit *>(node);
+            for (auto element: array->elements) {
+                dfs(element);
+            }
+            // the elements' common type, unknown if they differ
+            type_id element_type = array->elements.empty() ? (type_id) UNK : array->elements[0]->type;
+            for (auto element: array->elements) {
+                element_type = element->type == element_type ? element_type : (type_id) UNK;
             }
+            array->exp_t = TYPE_ARRAY;
+            array->type = types->array(element_type, (int) array->elements.size());
+            array->constant = fold_elements(CONST_ARRAY, array->elements);
+            break;
         }
+        case AST_NAMED_ARG: {
+            // only the target is typed, as in a call `f(x = 5)` it stands for the argument
+            auto *named_arg = static_cast<NamedArg *>(node);
+            dfs(named_arg->target);
+            dfs(named_arg->value);
+            named_arg->exp_t = named_arg->target->exp_t;
+            named_arg->type = named_arg->target->type;
+            break;
+        }
+        default:
+            break;
     }
 
-    for (auto child: children) {
-        dfs(child);
+    // operators and literals only have types without structure
+    if (node->kind >= AST_BINARY && static_cast<Expr *>(node)->type == UNK) {
+        static_cast<Expr *>(node)->type = exp_t_to_semantic_type(static_cast<Expr *>(node)->exp_t);
     }
+}
 
-    if (head_name == "var_declaration") {
-        int children_size = children[2]->get_children().size();
-        std::vector<std::string> names;
-        if (children_size == 3) {
-            names.push_back(children[2]->get_children()[1]->get_children()[0]->get_data().get_content());
-            auto tmp_child = children[2]->get_children()[1]->get_children()[1];
-            while (tmp_child->get_children()[0]->get_data().get_name() != "eps") {
-                names.push_back(tmp_child->get_children()[1]->get_data().get_content());
-                tmp_child = tmp_child->get_children()[2];
-            }
-        } else {
-            names.push_back(children[2]->get_children()[0]->get_data().get_content());
+// the interned type written in the source, UNK where none is given
+static type_id resolve_type(TypeTable &types, TypeExpr *type) {
+    if (type == nullptr) {
+        return UNK;
+    }
+    if (type->stype == ARRAY) {
+        return types.array(resolve_type(types, type->element), type->length);
+    }
+    if (type->stype == TUPLE) {
+        std::vector<type_id> elements;
+        for (auto element: type->elements) {
+            elements.push_back(resolve_type(types, element));
         }
-        if (children[3]->get_children()[0]->get_data().get_name() != "eps") {
-            if (children_size == 3) {
-                // We have (x, y, z, ...)
-
-                if (children[3]->get_children().empty()) {
-                    for (std::string name: names) {
-                        symbol_table[current_func][name].set_stype(UNK);
-                    }
-                } else {
-                    std::vector<semantic_type> tuple_type;
-                    tuple_type.push_back(
-                            children[3]->get_children()[1]->get_children()[1]->get_children()[0]->get_children()[0]->get_data().get_stype());
-                    auto tmp_child = children[3]->get_children()[1]->get_children()[1]->get_children()[1];
-                    while (tmp_child->get_children()[0]->get_data().get_name() != "eps") {
-                        tuple_type.push_back(tmp_child->get_children()[1]->get_children()[0]->get_data().get_stype());
-                        tmp_child = tmp_child->get_children()[2];
-                    }
+        return types.tuple(elements);
+    }
+    return type->stype;
+}
 
-                    if (tuple_type.size() == names.size()) {
-                        int idx = 0;
-                        for (std::string name: names) {
-                            symbol_table[current_func][name].set_stype(tuple_type[idx++]);
-                        }
-                    } else if (tuple_type.size() != names.size()) {
-                        std::cerr << RED << "Semantic Error [Line " << line_number << "]: "
-                                  << "Mismatch in tuple declaration for identifier '" << symbol.get_content() << "'.\n"
-                                  << "  - Declared " << names.size() << " variable(s) but provided "
-                                  << tuple_type.size() << " type(s).\n"
-                                  << "  - Ensure the number of variables matches the number of types in the tuple.\n"
-                                  << WHITE << std::endl;
-                        std::cerr << "----------------------------------------------------------------" << std::endl;
-                        num_errors++;
-                    }
-                }
-            } else {
-                // We have x
+void BodyChecker::report(diag_code code, int line_number, std::vector<std::string> args) {
+    diagnostics.push_back({code, line_number, std::move(args)});
+}
 
-                if (children[3]->get_children().size() == 1 and
-                    children[3]->get_children()[0]->get_data().get_name() == "eps") {
-                    symbol_table[current_func][names[0]].set_stype(UNK);
-                } else {
-                    int children_size_type = children[3]->get_children()[1]->get_children().size();
-                    if (children_size_type == 5) {
-                        symbol_table[current_func][names[0]].set_stype(ARRAY);
-                        symbol_table[current_func][names[0]].set_arr_len(
-                                stoi(children[3]->get_children()[1]->get_children()[3]->get_children()[0]->get_data().get_content()));
-                        symbol_table[current_func][names[0]].set_arr_type(
-                                (children[3]->get_children()[1]->get_children()[1]->get_children()[0]->get_data().get_name() ==
-                                 "T_Int") ? INT : BOOL);
-                    } else if (children_size_type == 3) {
-                        symbol_table[current_func][names[0]].set_stype(TUPLE);
-                        std::vector<semantic_type> tuple_type;
-                        tuple_type.push_back(
-                                children[3]->get_children()[1]->get_children()[1]->get_children()[0]->get_children()[0]->get_data().get_stype());
-                        auto tmp_child = children[3]->get_children()[1]->get_children()[1]->get_children()[1];
-                        while (tmp_child->get_children()[0]->get_data().get_name() != "eps") {
-                            tuple_type.push_back(
-                                    tmp_child->get_children()[1]->get_children()[0]->get_data().get_stype());
-                            tmp_child = tmp_child->get_children()[2];
-                        }
-
-                        for (semantic_type type: tuple_type) {
-                            symbol_table[current_func][names[0]].add_to_tuple_types(type);
-                        }
-                    } else {
-                        symbol_table[current_func][names[0]].set_stype(
-                                children[3]->get_children()[1]->get_children()[0]->get_data().get_stype());
-                    }
-                }
-            }
+void BodyChecker::check_identifier(const std::string &name, int line_number) {
+    if (!current_func.empty() && locals->find(name) < 0) {
+        if (globals->find_function(name) < 0) {
+            report(DIAG_UNDECLARED_IDENTIFIER, line_number, {name});
         }
+    }
+}
 
-        // handle <assign_opt>
-        if (children[4]->get_children()[0]->get_data().get_name() != "eps") {
-            if (children_size == 3) {
-                std::vector<semantic_type> tuple_type = children[4]->get_children()[1]->get_data().get_tuple_types();
-                if (tuple_type.size() != names.size()) {
-                    std::cerr << RED
-                              << "Semantic Error [Line " << line_number << "]: "
-                              << "Mismatch in tuple assignment for identifier '" << symbol.get_content() << "'.\n"
-                              << "  - Assigned " << tuple_type.size() << " value(s) but expected " << names.size()
-                              << ".\n"
-                              << "  - Ensure the number of assigned values matches the number of variables in the tuple.\n"
-                              << WHITE << std::endl;
-                    std::cerr << "----------------------------------------------------------------" << std::endl;
-                    num_errors++;
-                } else {
-                    int idx = 0;
-                    for (std::string name: names) {
-                        if (tuple_type[idx] == UNK) {
-                            std::cerr << RED << "Semantic Error [Line " << line_number << "]: "
-                                      << "Unable to infer type for variable '" << name
-                                      << "' from the assigned expression.\n"
-                                      << "  - The expression has an unsupported or unknown type.\n"
-                                      << "  - Ensure the expression is valid and has a type like int, bool, array, or tuple.\n"
-                                      << WHITE << std::endl;
-                            std::cerr << "----------------------------------------------------------------"
-                                      << std::endl;
-                            num_errors++;
-                        } else {
-                            symbol_table[current_func][name].set_stype(tuple_type[idx++]);
-                        }
-                    }
-                }
+// Checks a body against the signatures collected beforehand, its variables go in its own table.
+void BodyChecker::analyze_function(FuncDecl *func) {
+    int line_number = func->line;
+
+    current_func = func->name;
+    locals = &globals->get_locals(func->symbol);
+    locals->push_scope();
+    // a specialization's untyped parameters have the types it was made for
+    const std::vector<std::pair<std::string, type_id>> &params = (*globals)[func->symbol].get_parameters();
+    for (size_t i = 0; i < func->params.size(); i++) {
+        SymbolTableEntry arg_entry(VAR);
+        arg_entry.set_name(func->params[i]->name);
+        arg_entry.set_def_area(locals->depth());
+        arg_entry.set_mut(false);
+        arg_entry.set_stype(params[i].second);
+        func->params[i]->symbol = locals->declare(func->params[i]->name, arg_entry);
+    }
+
+    dfs(func->body);
+    dfs(func->ret);
+
+    // only a function without a declared type writes its entry, callers wait for it
+    SymbolTableEntry &entry = (*globals)[func->symbol];
+    if (func->ret == nullptr) {
+        if (entry.get_stype() != VOID) {
+            report(DIAG_MISSING_RETURN, line_number, {current_func, types->to_string(entry.get_stype())});
+        }
+    } else {
+        type_id stp = func->ret->type;
+        if (entry.get_stype() == UNK) {
+            if (stp == UNK) {
+                report(DIAG_RETURN_INFERENCE, line_number, {current_func});
             } else {
-                exp_type exp_t = children[4]->get_children()[1]->get_data().get_exp_type();
-                semantic_type s_type = exp_t_to_semantic_type(exp_t);
-                if (s_type == UNK) {
-                    std::cerr << RED << "Semantic Error [Line " << line_number << "]: "
-                              << "Unable to infer type for variable '" << names[0]
-                              << "' from the assigned expression.\n"
-                              << "  - The expression has an unsupported or unknown type.\n"
-                              << "  - Ensure the expression is valid and has a type like int, bool, array, or tuple.\n"
-                              << WHITE << std::endl;
-                    std::cerr << "----------------------------------------------------------------" << std::endl;
-                    num_errors++;
-                } else {
-                    symbol_table[current_func][names[0]].set_stype(s_type);
-                    if (s_type == TUPLE) {
-                        symbol_table[current_func][names[0]].add_to_tuple_types(
-                                children[4]->get_children()[1]->get_data().get_tuple_types());
-                    }
-                }
+                entry.set_stype(stp);
             }
+        } else if (entry.get_stype() != stp) {
+            report(DIAG_RETURN_TYPE, line_number,
+                   {current_func, types->to_string(entry.get_stype()), types->to_string(stp)});
         }
+    }
+
+    locals->pop_scope();
+    locals = globals;
+    current_func = "";
+}
 
-        // value
-        Node<Symbol> *assign_opt_node = children[4];
-        if (assign_opt_node->get_children()[0]->get_data().get_name() != "eps") {
-            if (names.size() == 1) {
-                std::string exp_val = assign_opt_node->get_children()[1]->get_data().get_val();
-                if (!exp_val.empty()) symbol_table[current_func][names[0]].set_val(exp_val);
+void BodyChecker::analyze_let(Let *let) {
+    int line_number = let->line;
+    const std::vector<std::string> &names = let->names;
 
-            }
+    // the initializer still sees the bindings the new names are about to shadow
+    dfs(let->init);
+
+    let->symbols.clear();
+    for (const auto &name: names) {
+        int handle = locals->find(name);
+        if (handle >= 0 && (*locals)[handle].get_def_area() == locals->depth()) {
+            report(DIAG_REDEFINITION, line_number, {name});
+            let->symbols.push_back(handle);
+        } else {
+            SymbolTableEntry x(VAR);
+            x.set_name(name);
+            x.set_mut(let->mut);
+            x.set_def_area(locals->depth());
+            let->symbols.push_back(locals->declare(name, x));
         }
-    } else if (head_name == "func") {
-        SymbolTableEntry &entry = symbol_table[""][current_func];
-        if (children[5]->get_children()[0]->get_data().get_name() != "eps") {
-            entry.set_stype(children[5]->get_children()[1]->get_data().get_stype());
-        }
-        Node<Symbol> *return_stmt_node = children[8];
-        if (return_stmt_node->get_children()[0]->get_data().get_name() == "eps") {
-            if (entry.get_stype() == UNK) entry.set_stype(VOID);
-            else if (entry.get_stype() != VOID) {
-                std::cerr << RED << "Semantic Error [Line " << line_number << "]: " << "Function '" << current_func
-                          << "' declared to return type '" << semantic_type_to_string[entry.get_stype()]
-                          << "' but has no return statement.\n"
-                          << "  - Ensure the function returns a value of the declared type or change the return type to 'void'.\n"
-                          << WHITE << std::endl;
-                std::cerr << "----------------------------------------------------------------" << std::endl;
-                num_errors++;
+    }
+
+    std::vector<type_id> declared(names.size(), UNK);
+    if (let->type != nullptr) {
+        type_id type = resolve_type(*types, let->type);
+        if (let->tuple_pattern) {
+            // We have (x, y, z, ...)
+            const std::vector<type_id> &tuple_type = (*types)[type].elements;
+            if (tuple_type.size() == names.size()) {
+                declared = tuple_type;
+            } else {
+                report(DIAG_TUPLE_DECLARATION, line_number,
+                       {ast_to_string(let).substr(4), std::to_string(names.size()),
+                        std::to_string(tuple_type.size())});
             }
         } else {
-            semantic_type stp = exp_t_to_semantic_type(
-                    return_stmt_node->get_children()[1]->get_data().get_exp_type());
-            if (entry.get_stype() == UNK) {
-                if (stp == UNK) {
-                    std::cerr << RED << "Semantic Error [Line " << line_number << "]: "
-                              << "Unable to infer return type for function '" << current_func
-                              << "' from the return expression.\n"
-                              << "  - The expression has an unsupported or unknown type.\n"
-                              << "  - Ensure the expression is valid and has a type like int, bool, array, or tuple.\n"
-                              << WHITE << std::endl;
-                    std::cerr << "----------------------------------------------------------------" << std::endl;
-                    num_errors++;
+            // We have x
+            declared[0] = type;
+        }
+        for (size_t i = 0; i < names.size(); i++) {
+            (*locals)[let->symbols[i]].set_stype(declared[i]);
+        }
+    }
+
+    if (let->init != nullptr) {
+        std::vector<type_id> init_types = {let->init->type};
+        if (let->tuple_pattern) {
+            const TypeInfo &init_type = (*types)[let->init->type];
+            init_types = init_type.kind == TUPLE ? init_type.elements : std::vector<type_id>();
+        }
+        if (init_types.size() != names.size()) {
+            report(DIAG_TUPLE_ASSIGNMENT, line_number,
+                   {ast_to_string(let).substr(4), std::to_string(init_types.size()), std::to_string(names.size())});
+        } else {
+            for (size_t i = 0; i < names.size(); i++) {
+                if (init_types[i] == UNK) {
+                    report(DIAG_VARIABLE_INFERENCE, line_number, {names[i]});
+                } else if (declared[i] != UNK && declared[i] != init_types[i]) {
+                    report(DIAG_VARIABLE_TYPE, line_number,
+                           {names[i], types->to_string(declared[i]), types->to_string(init_types[i])});
                 } else {
-                    entry.set_stype(stp);
-                }
-            } else {
-                if (entry.get_stype() != stp) {
-                    std::cerr << RED << "Semantic Error [Line " << line_number << "]: " << "Function '"
-                              << current_func
-                              << "' declared to return type '" << semantic_type_to_string[entry.get_stype()]
-                              << "' but has a return statement of type '" << semantic_type_to_string[stp] << "'.\n"
-                              << "  - Ensure the function returns a value of the declared type.\n" << WHITE
-                              << std::endl;
-                    std::cerr << "----------------------------------------------------------------" << std::endl;
-                    num_errors++;
-                }
-                if (entry.get_stype() == TUPLE && entry.get_tuple_types().size() !=
-                                                  return_stmt_node->get_children()[1]->get_data().get_tuple_types().size()) {
-                    std::cerr << RED << "Semantic Error [Line " << line_number << "]: " << "Function '"
-                              << current_func
-                              << "' declared to return a tuple of type '"
-                              << semantic_type_to_string[entry.get_stype()]
-                              << "' but the return statement has a different number of elements.\n"
-                              << "  - Ensure the number of elements in the returned tuple matches the declared type.\n"
-                              << WHITE << std::endl;
-                    std::cerr << "----------------------------------------------------------------" << std::endl;
-                    num_errors++;
+                    (*locals)[let->symbols[i]].set_stype(init_types[i]);
                 }
             }
         }
-    } else if (head_name == "T_Int") {
-        symbol.set_stype(INT);
-    } else if (head_name == "T_Bool") {
-        symbol.set_stype(BOOL);
-    } else if (head_name == "T_True" || head_name == "T_False") {
-        symbol.set_stype(BOOL);
-    } else if (head_name == "T_Id" and node->get_parent()->get_data().get_name() != "pattern" and
-               node->get_parent()->get_data().get_name() != "func" and
-               node->get_parent()->get_data().get_name() != "id_ls" and
-               node->get_parent()->get_data().get_name() != "id_ls_tail" and
-               node->get_parent()->get_data().get_name() != "arg") {
-        if (!current_func.empty() && !symbol_table[current_func].count(symbol.get_content())) {
-            if (!symbol_table[""].count(symbol.get_content())) {
-                std::cerr << RED << "Semantic Error [Line " << line_number << "]: "
-                          << "Use of undeclared identifier '"
-                          << symbol.get_content() << "'.\n"
-                          << "  - The identifier must be declared before it is used.\n"
-                          << "  - Check for missing declarations or typos in the name.\n" << WHITE << std::endl;
-                std::cerr << "----------------------------------------------------------------" << std::endl;
-                num_errors++;
+
+        // only an immutable binding keeps its value everywhere it is visible
+        const ConstValue &value = let->init->constant;
+        if (!let->mut && !let->tuple_pattern && names.size() == 1) {
+            (*locals)[let->symbols[0]].set_constant(value);
+        } else if (!let->mut && value.kind == CONST_TUPLE && value.elements.size() == names.size()) {
+            for (size_t i = 0; i < names.size(); i++) {
+                (*locals)[let->symbols[i]].set_constant(value.elements[i]);
             }
         }
-    } else if (head_name == "exp") {
-        symbol.set_exp_type(children[0]->get_data().get_exp_type());
-        symbol.add_to_tuple_types(children[0]->get_data().get_tuple_types());
-        symbol.set_val(children[0]->get_data().get_val());
-    } else if (head_name == "log_exp" or head_name == "rel_exp" or head_name == "eq_exp" or
-               head_name == "cmp_exp") {
-        Node<Symbol> *tail_node = children[1];
-        if (tail_node->get_children()[0]->get_data().get_name() != "eps") {
-            symbol.set_exp_type(TYPE_BOOL);
-        } else {
-            symbol.set_exp_type(children[0]->get_data().get_exp_type());
-            symbol.add_to_tuple_types(children[0]->get_data().get_tuple_types());
-            symbol.set_val(children[0]->get_data().get_val());
+    }
+}
+
+void BodyChecker::analyze_assign(Assign *assign) {
+    int line_number = assign->line;
+    const std::string &name = assign->name;
+    check_identifier(name, line_number);
+    dfs(assign->value);
+
+    int handle = locals->find(name);
+    if (handle >= 0) {
+        SymbolTableEntry &entry = (*locals)[handle];
+        if (!entry.get_mut()) {
+            report(DIAG_IMMUTABLE_VARIABLE, line_number, {name});
         }
-    } else if (head_name == "arith_exp" or head_name == "arith_term") {
-        if (children[1]->get_children()[0]->get_data().get_name() != "eps") {
-            symbol.set_exp_type(TYPE_INT);
-        } else {
-            symbol.set_exp_type(children[0]->get_data().get_exp_type());
-            symbol.add_to_tuple_types(children[0]->get_data().get_tuple_types());
+        type_id stp = assign->value->type;
+        if (entry.get_stype() == UNK) {
+            entry.set_stype(stp);
+        } else if (stp != UNK && stp != entry.get_stype()) {
+            report(DIAG_VARIABLE_TYPE, line_number, {name, types->to_string(entry.get_stype()), types->to_string(stp)});
         }
+    }
+}
 
-        // value
-        std::string current_val_str = children[0]->get_data().get_val();
-
-        Node<Symbol> *tail_node = children[1];
-        while (tail_node->get_children()[0]->get_data().get_name() != "eps") {
-            std::string op_name = tail_node->get_children()[0]->get_data().get_name();
-            std::string right_val_str = tail_node->get_children()[1]->get_data().get_val();
-
-            // Only perform calculation if both operands are constant.
-            if (!current_val_str.empty() && !right_val_str.empty()) {
-                long long left_val = std::stoll(current_val_str);
-                long long right_val = std::stoll(right_val_str);
-                long long result = 0;
-
-                if (op_name == "T_AOp_Trust") result = left_val + right_val;
-                else if (op_name == "T_AOp_MN") result = left_val - right_val;
-                else if (op_name == "T_AOp_ML") result = left_val * right_val;
-                else if (op_name == "T_AOp_DV") result = (right_val != 0) ? left_val / right_val : 0;
-                else if (op_name == "T_AOp_RM") result = (right_val != 0) ? left_val % right_val : 0;
-
-                current_val_str = std::to_string(result);
-            } else {
-                current_val_str = "";
-            }
-            tail_node = tail_node->get_children()[2];
-        }
-        symbol.set_val(current_val_str);
-    } else if (head_name == "arith_factor") {
-        if (children[0]->get_data().get_name() == "T_Hexadecimal" or
-            children[0]->get_data().get_name() == "T_Decimal") {
-            symbol.set_exp_type(TYPE_INT);
-            symbol.set_val(children[0]->get_data().get_content());
-        } else if (children[0]->get_data().get_name() == "T_String") {
-            symbol.set_exp_type(TYPE_STRING);
-        } else if (children[0]->get_data().get_name() == "T_True" ||
-                   children[0]->get_data().get_name() == "T_False") {
-            symbol.set_exp_type(TYPE_BOOL);
-            if (children[0]->get_data().get_name() == "T_True") {
-                symbol.set_val("true");
-            } else {
-                symbol.set_val("false");
-            }
-        } else if (children[0]->get_data().get_name() == "T_LOp_NOT") {
-            Node<Symbol> *operand_node = children[1];
-            exp_type operand_type = operand_node->get_data().get_exp_type();
-            if (operand_type != TYPE_BOOL) {
-                std::cerr << RED << "Semantic Error [Line " << line_number << "]: "
-                          << "Logical NOT operator '!' cannot be applied to a non-boolean type.\n"
-                          << "  - Expected operand of type 'bool' but got '" << exp_t_to_string(operand_type)
-                          << "'.\n"
-                          << WHITE << std::endl;
-                std::cerr << "----------------------------------------------------------------" << std::endl;
-                num_errors++;
-            }
-            symbol.set_exp_type(TYPE_BOOL);
-            std::string operand_val = operand_node->get_data().get_val();
-            if (operand_val == "true") {
-                symbol.set_val("false");
-            } else if (operand_val == "false") {
-                symbol.set_val("true");
-            }
-        } else if (children[0]->get_data().get_name() == "T_AOp_MN") { // Handle unary minus
-            Node<Symbol> *operand_node = children[1];
-            exp_type operand_type = operand_node->get_data().get_exp_type();
-
-            if (operand_type != TYPE_INT) {
-                std::cerr << RED << "Semantic Error [Line " << line_number << "]: "
-                          << "Unary minus operator '-' cannot be applied to a non-integer type.\n"
-                          << "  - Expected operand of type 'int' but got '" << exp_t_to_string(operand_type)
-                          << "'.\n"
-                          << WHITE << std::endl;
-                std::cerr << "----------------------------------------------------------------" << std::endl;
-                num_errors++;
+void BodyChecker::analyze_index_assign(IndexAssign *assign) {
+    int line_number = assign->line;
+    const std::string &name = assign->name;
+    check_identifier(name, line_number);
+    dfs(assign->index);
+    dfs(assign->value);
+
+    // Check 1: Is the variable an array and mutable?
+    int handle = locals->find(name);
+    if (handle < 0 || types->kind((*locals)[handle].get_stype()) != ARRAY) {
+        report(DIAG_NOT_AN_ARRAY, line_number, {name});
+    } else if (!(*locals)[handle].get_mut()) {
+        report(DIAG_IMMUTABLE_ARRAY, line_number, {name});
+    } else {
+        // Check 2: Is the index type i32 and not negative?
+        Expr *index = assign->index;
+        if (index->exp_t != TYPE_INT) {
+            report(DIAG_INDEX_ASSIGN_TYPE, line_number, {name, exp_t_to_string(index->exp_t)});
+        } else if (index->constant.kind == CONST_INT) {
+            int32_t index_val = index->constant.number;
+            if (index_val < 0) {
+                report(DIAG_NEGATIVE_INDEX_ASSIGN, line_number, {name, std::to_string(index_val)});
             }
+        }
 
-            symbol.set_exp_type(TYPE_INT);
-
-            // Handle constant folding
-            std::string operand_val = operand_node->get_data().get_val();
-            if (!operand_val.empty()) {
-                try {
-                    long long val = std::stoll(operand_val);
-                    symbol.set_val(std::to_string(-val));
-                } catch (const std::invalid_argument &ia) {
-                    // Not a number, can't fold. Do nothing.
-                }
-            }
-        } else if (children[0]->get_data().get_name() == "T_Id") {
-            auto fac_id_opt = children[1]->get_children()[0];
-            std::string id_name = children[0]->get_data().get_content();
-
-            // value
-            if (fac_id_opt->get_data().get_name() == "eps") {
-                // It's a variable
-                if (symbol_table[current_func].count(id_name)) {
-                    symbol.set_val(symbol_table[current_func][id_name].get_val());
-                }
-            }
+        // Check 3: Does the assigned value's type match the array's element type?
+        type_id array_element_type = (*types)[(*locals)[handle].get_stype()].element;
+        type_id assigned_value_type = assign->value->type;
 
-            if (fac_id_opt->get_data().get_name() == "T_LP") {
-                std::vector<std::pair<std::string, semantic_type>> &expected_params = symbol_table[""][id_name].get_parameters();
-                std::vector<semantic_type> provided_arg_types;
+        if (assigned_value_type != UNK && array_element_type != UNK && array_element_type != assigned_value_type) {
+            report(DIAG_ARRAY_ELEMENT_TYPE, line_number,
+                   {name, types->to_string(array_element_type), types->to_string(assigned_value_type)});
+        }
+    }
+}
 
-                Node<Symbol> *exp_ls_call_node = fac_id_opt->get_parent()->get_children()[1];
+void BodyChecker::analyze_if(If *if_stmt) {
+    int line_number = if_stmt->line;
+    locals->push_scope();
 
-                if (exp_ls_call_node->get_children().empty() ||
-                    exp_ls_call_node->get_children()[0]->get_data().get_name() == "eps") {
-                    // Function called with no arguments
-                } else {
-                    Node<Symbol> *exp_ls_node = exp_ls_call_node->get_children()[0];
-                    if (!exp_ls_node->get_children().empty() &&
-                        exp_ls_node->get_children()[0]->get_data().get_name() != "eps") {
-                        Node<Symbol> *current_arg_item = exp_ls_node->get_children()[0];
-                        Node<Symbol> *current_exp = current_arg_item->get_children()[0];
-                        provided_arg_types.push_back(exp_t_to_semantic_type(current_exp->get_data().get_exp_type()));
-
-                        Node<Symbol> *exp_ls_tail_node = exp_ls_node->get_children()[1];
-                        while (!exp_ls_tail_node->get_children().empty() &&
-                               exp_ls_tail_node->get_children()[0]->get_data().get_name() != "eps") {
-                            current_arg_item = exp_ls_tail_node->get_children()[1];
-                            current_exp = current_arg_item->get_children()[0];
-                            provided_arg_types.push_back(
-                                    exp_t_to_semantic_type(current_exp->get_data().get_exp_type()));
-                            exp_ls_tail_node = exp_ls_tail_node->get_children()[2];
-                        }
-                    }
-                }
+    dfs(if_stmt->cond);
+    dfs(if_stmt->then_block);
+    if (if_stmt->else_branch != nullptr) {
+        locals->push_scope();
+        dfs(if_stmt->else_branch);
+        locals->pop_scope();
+    }
 
-                if (expected_params.size() != provided_arg_types.size()) {
-                    std::cerr << RED << "Semantic Error [Line " << line_number << "]: "
-                              << "Incorrect number of arguments in call to function '" << id_name << "'.\n"
-                              << "  - Expected " << expected_params.size() << " argument(s), but got "
-                              << provided_arg_types.size() << ".\n"
-                              << WHITE << std::endl;
-                    std::cerr << "----------------------------------------------------------------" << std::endl;
-                    num_errors++;
-                } else {
-                    for (size_t i = 0; i < expected_params.size(); ++i) {
-                        if (expected_params[i].second == UNK) {
-                            if (provided_arg_types[i] != UNK) {
-                                symbol_table[""][id_name].get_parameters()[i].second = provided_arg_types[i];
-                            }
-                        } else if (provided_arg_types[i] != UNK &&
-                                   expected_params[i].second != provided_arg_types[i]) {
-                            std::cerr << RED << "Semantic Error [Line " << line_number << "]: "
-                                      << "Type mismatch in arguments of call to function '" << id_name
-                                      << "'.\n  - Expected argument " << i + 1 << " to be of type '"
-                                      << semantic_type_to_string[expected_params[i].second]
-                                      << "' but got type '" << semantic_type_to_string[provided_arg_types[i]] << "'.\n"
-                                      << WHITE << std::endl;
-                            std::cerr << "----------------------------------------------------------------"
-                                      << std::endl;
-                            num_errors++;
-                        }
-                    }
-                }
+    if (if_stmt->cond == nullptr || if_stmt->cond->exp_t != TYPE_BOOL) {
+        report(DIAG_IF_CONDITION, line_number);
+    }
+    locals->pop_scope();
+}
 
-                semantic_type func_return_type = symbol_table[""][id_name].get_stype();
-                exp_type call_exp_type;
-                switch (func_return_type) {
-                    case INT:
-                        call_exp_type = TYPE_INT;
-                        break;
-                    case BOOL:
-                        call_exp_type = TYPE_BOOL;
-                        break;
-                    case ARRAY:
-                        call_exp_type = TYPE_ARRAY;
-                        break;
-                    case TUPLE:
-                        call_exp_type = TYPE_TUPLE;
-                        break;
-                    case VOID:
-                        call_exp_type = TYPE_VOID;
-                        break;
-                    default:
-                        call_exp_type = TYPE_UNKNOWN;
-                        break;
-                }
-                symbol.set_exp_type(call_exp_type);
-            } else if (fac_id_opt->get_data().get_name() == "T_LB") {
-                // Check if the identifier is declared as an array
-                if (!symbol_table[current_func].count(id_name) ||
-                    symbol_table[current_func][id_name].get_stype() != ARRAY) {
-                    std::cerr << RED << "Semantic Error [Line " << line_number << "]: Identifier '" << id_name
-                              << "' is not an array and cannot be indexed.\n" << WHITE << std::endl;
-                    std::cerr << "----------------------------------------------------------------" << std::endl;
-                    num_errors++;
-                    symbol.set_exp_type(TYPE_UNKNOWN);
-                } else {
-                    // check if the index expression is of type 'i32' and not negative
-                    Node<Symbol> *index_exp_node = children[1]->get_children()[1];
-                    if (index_exp_node->get_data().get_exp_type() != TYPE_INT) {
-                        std::cerr << RED << "Semantic Error [Line " << line_number << "]: "
-                                  << "Array index for '" << id_name << "' must be of type 'i32'.\n"
-                                  << "  - The provided index expression is not an integer, it is "
-                                  << exp_t_to_string(index_exp_node->get_data().get_exp_type()) << ".\n" << WHITE
-                                  << std::endl;
-                        std::cerr << "----------------------------------------------------------------"
-                                  << std::endl;
-                        num_errors++;
-                    }
+void BodyChecker::analyze_call(Call *call) {
+    int line_number = call->line;
+    const std::string &id_name = call->name;
+    check_identifier(id_name, line_number);
+    for (auto arg: call->args) {
+        dfs(arg);
+    }
 
-                    std::string index_val_str = index_exp_node->get_data().get_val();
-                    if (!index_val_str.empty()) {
-                        long long index_val = std::stoll(index_val_str);
-                        if (index_val < 0) {
-                            std::cerr << RED << "Semantic Error [Line " << line_number << "]: "
-                                      << "Array index cannot be negative. Got: " << index_val << " for array '"
-                                      << id_name << "'.\n" << WHITE << std::endl;
-                            std::cerr << "----------------------------------------------------------------"
-                                      << std::endl;
-                            num_errors++;
-                        }
-                    }
+    // an undeclared function was reported by check_identifier, there is nothing to match against
+    int func = globals->find_function(id_name);
+    if (func < 0) {
+        call->exp_t = TYPE_UNKNOWN;
+        return;
+    }
 
-                    // type of the array's elements
-                    semantic_type arr_elem_type = symbol_table[current_func][id_name].get_arr_type();
-                    exp_type call_exp_type;
-                    switch (arr_elem_type) {
-                        case INT:
-                            call_exp_type = TYPE_INT;
-                            break;
-                        case BOOL:
-                            call_exp_type = TYPE_BOOL;
-                            break;
-                        default:
-                            call_exp_type = TYPE_UNKNOWN;
-                            break;
-                    }
-                    symbol.set_exp_type(call_exp_type);
-                }
-            } else {
-                if (symbol_table[current_func].count(id_name)) {
-                    semantic_type var_stype = symbol_table[current_func][id_name].get_stype();
-                    exp_type call_exp_type;
-                    switch (var_stype) {
-                        case INT:
-                            call_exp_type = TYPE_INT;
-                            break;
-                        case BOOL:
-                            call_exp_type = TYPE_BOOL;
-                            break;
-                        case ARRAY:
-                            call_exp_type = TYPE_ARRAY;
-                            break;
-                        case TUPLE:
-                            call_exp_type = TYPE_TUPLE;
-                            break;
-                        case VOID:
-                            call_exp_type = TYPE_VOID;
-                            break;
-                        default:
-                            call_exp_type = TYPE_UNKNOWN;
-                            break;
-                    }
-                    symbol.set_exp_type(call_exp_type);
-                    if (var_stype == TUPLE) {
-                        symbol.add_to_tuple_types(symbol_table[current_func][id_name].get_tuple_types());
-                    }
-                } else {
-                    symbol.set_exp_type(TYPE_UNKNOWN);
-                }
-            }
-        } else if (children[0]->get_data().get_name() == "T_LP") {
-            // value
-            if (children[1]->get_children()[1]->get_children()[0]->get_data().get_name() == "T_RP")
-                symbol.set_val(children[1]->get_children()[0]->get_data().get_val());
-
-            if (children[1]->get_children()[1]->get_children()[0]->get_data().get_name() == "T_RP") {
-                // parentheses
-                symbol.set_exp_type(children[1]->get_children()[0]->get_data().get_exp_type());
-            } else if (children[1]->get_children()[1]->get_children()[0]->get_data().get_name() == "T_Comma") {
-                // tuple
-                symbol.set_exp_type(TYPE_TUPLE);
-                std::vector<semantic_type> tuple_type;
-                tuple_type.push_back(
-                        exp_t_to_semantic_type(children[1]->get_children()[0]->get_data().get_exp_type()));
-                auto tmp_node = children[1]->get_children()[1]->get_children()[1];
-                if (tmp_node->get_data().get_name() != "eps") {
-                    tuple_type.push_back(
-                            exp_t_to_semantic_type(tmp_node->get_children()[0]->get_data().get_exp_type()));
-                    tmp_node = tmp_node->get_children()[1];
-                    while (tmp_node->get_children()[0]->get_data().get_name() != "eps") {
-                        tuple_type.push_back(
-                                exp_t_to_semantic_type(tmp_node->get_children()[1]->get_data().get_exp_type()));
-                        tmp_node = tmp_node->get_children()[2];
-                    }
-                }
-                symbol.add_to_tuple_types(tuple_type);
-            }
-        } else if (children[0]->get_data().get_name() == "T_LB") {
-            // array literal
-            symbol.set_exp_type(TYPE_ARRAY);
-        }
-    } else if (head_name == "stmt_after_id") {
-        std::string name = node->get_parent()->get_children()[0]->get_data().get_content();
-
-        // Handles simple assignment: x = 2;
-        if (children[0]->get_data().get_name() == "T_Assign") {
-            if (symbol_table[current_func].count(name)) {
-                if (!symbol_table[current_func][name].get_mut()) {
-                    std::cerr << RED << "Semantic Error [Line " << line_number << "]: "
-                              << "Cannot assign to immutable variable '" << name << "'.\n"
-                              << "  - This variable was not declared as mutable (e.g., 'let mut " << name << "').\n"
-                              << "  - To allow mutation, declare the variable with the 'mut' keyword.\n" << WHITE
-                              << std::endl;
-                    std::cerr << "----------------------------------------------------------------" << std::endl;
-                    num_errors++;
-                }
-                semantic_type stp = exp_t_to_semantic_type(children[1]->get_data().get_exp_type());
-                if (symbol_table[current_func][name].get_stype() == UNK) {
-                    symbol_table[current_func][name].set_stype(stp);
-                } else if (stp != UNK && stp != symbol_table[current_func][name].get_stype()) {
-                    std::cerr << RED << "Semantic Error [Line " << line_number << "]: "
-                              << "Type mismatch for variable '" << name << "'.\n" << "  - Expected type '"
-                              << semantic_type_to_string[symbol_table[current_func][name].get_stype()]
-                              << "' but got type '" << semantic_type_to_string[stp] << "'.\n"
-                              << "  - Ensure the assigned value matches the variable's declared type.\n" << WHITE
-                              << std::endl;
-                    std::cerr << "----------------------------------------------------------------" << std::endl;
-                    num_errors++;
-                }
+    std::vector<type_id> provided_arg_types;
+    for (auto arg: call->args) {
+        provided_arg_types.push_back(arg->type);
+    }
 
-                // value
-                std::string exp_val = children[1]->get_data().get_val();
-                symbol_table[current_func][name].set_val(exp_val);
+    size_t num_params = (*globals)[func].get_parameters().size();
+    if (num_params != provided_arg_types.size()) {
+        report(DIAG_ARGUMENT_COUNT, line_number,
+               {id_name, std::to_string(num_params), std::to_string(provided_arg_types.size())});
+    } else {
+        if (owner.generics.count(func)) {
+            func = owner.specialize(func, provided_arg_types);
+        }
+        const std::vector<std::pair<std::string, type_id>> &expected_params = (*globals)[func].get_parameters();
+        for (size_t i = 0; i < expected_params.size(); ++i) {
+            if (expected_params[i].second != UNK && provided_arg_types[i] != UNK &&
+                expected_params[i].second != provided_arg_types[i]) {
+                report(DIAG_ARGUMENT_TYPE, line_number,
+                       {id_name, std::to_string(i + 1), types->to_string(expected_params[i].second),
+                        types->to_string(provided_arg_types[i])});
             }
-            // Handles array element assignment: x[y] = 2;
-        } else if (children[0]->get_data().get_name() == "T_LB") {
-            // Check 1: Is the variable an array and mutable?
-            if (!symbol_table[current_func].count(name) || symbol_table[current_func][name].get_stype() != ARRAY) {
-                std::cerr << RED << "Semantic Error [Line " << line_number << "]: Identifier '" << name
-                          << "' is not an array and cannot be indexed.\n" << WHITE << std::endl;
-                std::cerr << "----------------------------------------------------------------" << std::endl;
-                num_errors++;
-            } else if (!symbol_table[current_func][name].get_mut()) {
-                std::cerr << RED << "Semantic Error [Line " << line_number << "]: "
-                          << "Cannot assign to an element of immutable array '" << name << "'.\n"
-                          << "  - To allow mutation, declare the array with 'mut'.\n" << WHITE << std::endl;
-                std::cerr << "----------------------------------------------------------------" << std::endl;
-                num_errors++;
-            } else {
-                // Check 2: Is the index type i32 and not negative?
-                Node<Symbol> *index_exp_node = children[1];
-                if (index_exp_node->get_data().get_exp_type() != TYPE_INT) {
-                    std::cerr << RED << "Semantic Error [Line " << line_number << "]: "
-                              << "Array index for '" << name << "' must be of type 'i32'.\n"
-                              << "  - The provided index has type "
-                              << exp_t_to_string(index_exp_node->get_data().get_exp_type()) << ".\n" << WHITE
-                              << std::endl;
-                    std::cerr << "----------------------------------------------------------------" << std::endl;
-                    num_errors++;
-                }
+        }
+    }
 
-                std::string index_val_str = index_exp_node->get_data().get_val();
-                if (!index_val_str.empty()) {
-                    long long index_val = std::stoll(index_val_str);
-                    if (index_val < 0) {
-                        std::cerr << RED << "Semantic Error [Line " << line_number << "]: "
-                                  << "Array index for assignment cannot be negative. Got: " << index_val
-                                  << " for array '" << name << "'.\n" << WHITE << std::endl;
-                        std::cerr << "----------------------------------------------------------------"
-                                  << std::endl;
-                        num_errors++;
-                    }
-                }
+    call->symbol = func;
+    call->type = (*globals)[func].get_stype();
+    call->exp_t = semantic_type_to_exp_t(types->kind(call->type));
 
-                // Check 3: Does the assigned value's type match the array's element type?
-                semantic_type array_element_type = symbol_table[current_func][name].get_arr_type();
-                semantic_type assigned_value_type = exp_t_to_semantic_type(children[4]->get_data().get_exp_type());
-
-                if (assigned_value_type != UNK && array_element_type != assigned_value_type) {
-                    std::cerr << RED << "Semantic Error [Line " << line_number << "]: "
-                              << "Type mismatch in assignment to array '" << name << "'.\n"
-                              << "  - Array elements have type '" << semantic_type_to_string[array_element_type]
-                              << "' but assigned value has type '" << semantic_type_to_string[assigned_value_type]
-                              << "'.\n" << WHITE << std::endl;
-                    std::cerr << "----------------------------------------------------------------" << std::endl;
-                    num_errors++;
-                }
-            }
+    // a pure function called with constants is run now, the call is folded if it finishes within budget
+    if (!evaluator->is_pure(id_name)) {
+        return;
+    }
+    std::vector<ConstValue> args;
+    for (auto arg: call->args) {
+        if (!arg->constant.known()) {
+            return;
         }
-    } else if (head_name == "if_stmt") {
-        if (children[1]->get_data().get_exp_type() != TYPE_BOOL) {
-            std::cerr << RED << "Semantic Error [Line " << line_number << "]: "
-                      << "Condition in 'if' statement must be of type 'bool'.\n"
-                      << "  - The expression used in the condition is not a boolean expression.\n"
-                      << "  - Ensure the condition evaluates to a boolean value (true or false).\n" << WHITE
-                      << std::endl;
-            std::cerr << "----------------------------------------------------------------" << std::endl;
-            num_errors++;
+        args.push_back(arg->constant);
+    }
+    call->constant = evaluator->call(id_name, args);
+}
+
+void BodyChecker::analyze_index(Index *index) {
+    int line_number = index->line;
+    const std::string &id_name = index->name;
+    check_identifier(id_name, line_number);
+    dfs(index->index);
+
+    // Check if the identifier is declared as an array
+    int handle = locals->find(id_name);
+    if (handle < 0 || types->kind((*locals)[handle].get_stype()) != ARRAY) {
+        report(DIAG_NOT_AN_ARRAY, line_number, {id_name});
+        index->exp_t = TYPE_UNKNOWN;
+        return;
+    }
+
+    // check if the index expression is of type 'i32' and not negative
+    Expr *index_exp = index->index;
+    if (index_exp->exp_t != TYPE_INT) {
+        report(DIAG_INDEX_TYPE, line_number, {id_name, exp_t_to_string(index_exp->exp_t)});
+    } else if (index_exp->constant.kind == CONST_INT) {
+        int32_t index_val = index_exp->constant.number;
+        if (index_val < 0) {
+            report(DIAG_NEGATIVE_INDEX, line_number, {id_name, std::to_string(index_val)});
         }
-    } else if (head_name == "log_exp_tail" || head_name == "rel_exp_tail") {
-        if (children[0]->get_data().get_name() != "eps") {
+    }
 
-            Node<Symbol> *parent = node->get_parent();
-            std::string parent_name = parent->get_data().get_name();
-            Node<Symbol> *left_operand_node = nullptr;
+    // type of the array's elements
+    index->type = (*types)[(*locals)[handle].get_stype()].element;
+    index->exp_t = semantic_type_to_exp_t(types->kind(index->type));
+    const ConstValue &array = (*locals)[handle].get_constant();
+    if (array.kind == CONST_ARRAY && index_exp->constant.kind == CONST_INT && index_exp->constant.number >= 0 &&
+        index_exp->constant.number < (int32_t) array.elements.size()) {
+        index->constant = array.elements[index_exp->constant.number];
+    }
+}
 
-            if (parent_name == "log_exp" || parent_name == "rel_exp") {
-                left_operand_node = parent->get_children()[0];
-            } else {
-                // <Op> <exp> <tail>
-                left_operand_node = parent->get_children()[1];
-            }
+void BodyChecker::analyze_binary(Binary *binary) {
+    int line_number = binary->line;
+    dfs(binary->lhs);
+    dfs(binary->rhs);
 
-            semantic_type stp_l = exp_t_to_semantic_type(left_operand_node->get_data().get_exp_type());
-            semantic_type stp_r = exp_t_to_semantic_type(children[1]->get_data().get_exp_type());
+    semantic_type stp_l = exp_t_to_semantic_type(binary->lhs->exp_t);
+    semantic_type stp_r = exp_t_to_semantic_type(binary->rhs->exp_t);
 
+    switch (binary->op) {
+        case OP_OR:
+        case OP_AND: {
             // error for logical operate, operand is boolean
             if (stp_l != BOOL) {
-                std::cerr << RED
-                          << "Semantic Error [Line " << line_number << "]: "
-                          << "Left operand of logical operator must be of type 'bool'.\n"
-                          << "  - The left operand has type '" << semantic_type_to_string[stp_l]
-                          << "' which is not boolean.\n"
-                          << "  - Ensure the left operand is a boolean expression (true or false).\n"
-                          << WHITE << std::endl;
-                std::cerr << "----------------------------------------------------------------" << std::endl;
-                num_errors++;
+                report(DIAG_LOGICAL_LEFT, line_number, {semantic_type_to_string[stp_l]});
             }
 
             if (stp_r != BOOL) {
-                std::cerr << RED
-                          << "Semantic Error [Line " << line_number << "]: "
-                          << "Right operand of logical operator must be of type 'bool'.\n"
-                          << "  - The right operand has type '" << semantic_type_to_string[stp_r]
-                          << "' which is not boolean.\n"
-                          << "  - Ensure the right operand is a boolean expression (true or false).\n"
-                          << WHITE << std::endl;
-                std::cerr << "----------------------------------------------------------------" << std::endl;
-                num_errors++;
+                report(DIAG_LOGICAL_RIGHT, line_number, {semantic_type_to_string[stp_r]});
             }
 
-            // value
-            std::string left_val_str = left_operand_node->get_data().get_val();
-            std::string right_val_str = children[1]->get_data().get_val();
+            binary->exp_t = TYPE_BOOL;
+            break;
+        }
+        case OP_EQ:
+        case OP_NE: {
+            if (binary->lhs->type != binary->rhs->type) {
+                report(DIAG_EQUALITY_TYPES, line_number,
+                       {types->to_string(binary->lhs->type), types->to_string(binary->rhs->type)});
+            }
 
-            if ((left_val_str == "true" || left_val_str == "false") &&
-                (right_val_str == "true" || right_val_str == "false")) {
+            binary->exp_t = TYPE_BOOL;
+            break;
+        }
+        case OP_LT:
+        case OP_LE:
+        case OP_GT:
+        case OP_GE: {
+            if (stp_l != INT) {
+                report(DIAG_COMPARISON_LEFT, line_number, {semantic_type_to_string[stp_l]});
+            }
 
-                bool left_bool = (left_val_str == "true");
-                bool right_bool = (right_val_str == "true");
-                bool result = false;
+            if (stp_r != INT) {
+                report(DIAG_COMPARISON_RIGHT, line_number, {semantic_type_to_string[stp_r]});
+            }
 
-                if (head_name == "log_exp_tail") {
-                    result = left_bool || right_bool;
-                } else {
-                    result = left_bool && right_bool;
-                }
+            binary->exp_t = TYPE_BOOL;
+            break;
+        }
+        default: {
+            if (stp_l != INT) {
+                report(DIAG_ARITHMETIC_LEFT, line_number, {semantic_type_to_string[stp_l]});
+            }
 
-                node->get_parent()->get_data().set_val(result ? "true" : "false");
+            if (stp_r != INT) {
+                report(DIAG_ARITHMETIC_RIGHT, line_number, {semantic_type_to_string[stp_r]});
             }
-        }
-    } else if (head_name == "eq_exp_tail") {
-        if (children[0]->get_data().get_name() != "eps") {
-            semantic_type stp_l = exp_t_to_semantic_type(
-                    node->get_parent()->get_children()[0]->get_data().get_exp_type());
-            semantic_type stp_r = exp_t_to_semantic_type(children[1]->get_data().get_exp_type());
-
-            if (stp_l != stp_r) {
-                std::cerr << RED
-                          << "Semantic Error [Line " << line_number << "]: "
-                          << "Operands of equality operator must have the same type.\n"
-                          << "  - Left operand has type '" << semantic_type_to_string[stp_l]
-                          << "' and right operand has type '" << semantic_type_to_string[stp_r] << "'.\n"
-                          << "  - Ensure both operands are of the same type for comparison.\n"
-                          << WHITE << std::endl;
-                std::cerr << "----------------------------------------------------------------" << std::endl;
-                num_errors++;
+
+            binary->exp_t = TYPE_INT;
+
+            if ((binary->op == OP_DIV || binary->op == OP_REM) && binary->rhs->constant.kind == CONST_INT &&
+                binary->rhs->constant.number == 0) {
+                report(DIAG_DIVISION_BY_ZERO, line_number, {ast_op_to_string[binary->op]});
             }
+            break;
         }
+    }
+
+    binary->constant = fold_binary(binary->op, binary->lhs->constant, binary->rhs->constant);
+}
 
-        // value
-        if (children[0]->get_data().get_name() != "eps") {
-            std::string left_val_str = node->get_parent()->get_children()[0]->get_data().get_val();
-            std::string right_val_str = children[1]->get_data().get_val();
+void BodyChecker::analyze_unary(Unary *unary) {
+    int line_number = unary->line;
+    Expr *operand = unary->operand;
+    dfs(operand);
+    exp_type operand_type = operand->exp_t;
+
+    if (unary->op == OP_NOT) {
+        if (operand_type != TYPE_BOOL) {
+            report(DIAG_NOT_OPERAND, line_number, {exp_t_to_string(operand_type)});
+        }
+        unary->exp_t = TYPE_BOOL;
+        if (operand->constant.kind == CONST_BOOL) {
+            unary->constant = ConstValue::of_bool(!operand->constant.number);
+        }
+    } else {
+        if (operand_type != TYPE_INT) {
+            report(DIAG_NEG_OPERAND, line_number, {exp_t_to_string(operand_type)});
+        }
+        unary->exp_t = TYPE_INT;
+        if (operand->constant.kind == CONST_INT) {
+            unary->constant = ConstValue::of_int(wrap_i32(-(int64_t) operand->constant.number));
+        }
+    }
+}
 
-            if (!left_val_str.empty() && !right_val_str.empty()) {
-                std::string op_name = children[0]->get_data().get_name();
-                bool result = false;
+void SemanticAnalyzer::check_for_main_function() {
 
-                if (op_name == "T_ROp_E") result = (left_val_str == right_val_str);
-                else if (op_name == "T_ROp_NE") result = (left_val_str != right_val_str);
+    if (symbol_table.find_function("main") < 0) {
+        diagnostics.push_back({DIAG_NO_MAIN, 0, {}});
+    }
+}
 
-                node->get_parent()->get_data().set_val(result ? "true" : "false");
+/*
+    First pass: enters every function with its declared signature, so a body may call a function
+    declared after it. A function without a declared return type gets its type from its body, so
+    the bodies calling it are put in a later wave; the bodies of one wave only read the table.
+    Inside a cycle of such functions the earliest one is checked first and its callees stay unknown.
+    A function with untyped parameters is only checked through its calls, so its callers come
+    after it as well.
+*/
+void SemanticAnalyzer::collect_signatures(std::vector<ItemCheck> &items, std::vector<std::vector<int>> &waves) {
+    std::vector<int> funcs;
+    for (size_t id = 0; id < program->items.size(); id++) {
+        if (program->items[id]->kind != AST_FUNC_DECL) {
+            continue;
+        }
+        auto *func = static_cast<FuncDecl *>(program->items[id]);
+        if (symbol_table.find_function(func->name) >= 0) {
+            items[id].diagnostics.push_back({DIAG_FUNCTION_REDECLARATION, func->line, {func->name}});
+        }
+        SymbolTableEntry func_entry(FUNC);
+        func_entry.set_name(func->name);
+        if (func->ret_type != nullptr) {
+            func_entry.set_stype(resolve_type(type_table, func->ret_type));
+        } else if (func->ret == nullptr) {
+            func_entry.set_stype(VOID);
+        }
+        bool generic = false;
+        for (auto param: func->params) {
+            func_entry.add_to_parameters({param->name, resolve_type(type_table, param->type)});
+            generic = generic || param->type == nullptr;
+        }
+        if (symbol_table.find_function(func->name) < 0) {
+            const_evaluator.add_function(func);
+        }
+        func->symbol = symbol_table.add_function(func->name, func_entry);
+        if (generic) {
+            std::vector<type_id> params;
+            for (const auto &param: func_entry.get_parameters()) {
+                params.push_back(param.second);
             }
+            generics[func->symbol] = {func, params, func_entry.get_stype()};
+        }
+        funcs.push_back((int) id);
+        if (SEMANTIC_CACHE && !cache_address.empty()) {
+            items[id].hash = SemanticCache::hash_function(func);
         }
-    } else if (head_name == "cmp_exp_suf") {
-        if (children[0]->get_data().get_name() != "eps") {
-            semantic_type stp_l = exp_t_to_semantic_type(
-                    node->get_parent()->get_children()[0]->get_data().get_exp_type());
-            semantic_type stp_r = exp_t_to_semantic_type(children[1]->get_data().get_exp_type());
+    }
+    const_evaluator.mark_pure_functions();
+    if (SEMANTIC_CACHE && !cache_address.empty()) {
+        hash_pure_functions(items);
+    }
 
-            if (stp_l != INT) {
-                std::cerr << RED
-                          << "Semantic Error [Line " << line_number << "]: "
-                          << "Left operand of comparison operator must be of type 'int'.\n"
-                          << "  - The left operand has type '" << semantic_type_to_string[stp_l]
-                          << "' which is not integer.\n"
-                          << "  - Ensure the left operand is an integer expression.\n"
-                          << WHITE << std::endl;
-                std::cerr << "----------------------------------------------------------------" << std::endl;
-                num_errors++;
+    std::map<int, int> order;
+    for (size_t i = 0; i < funcs.size(); i++) {
+        order[static_cast<FuncDecl *>(program->items[funcs[i]])->symbol] = (int) i;
+    }
+    std::vector<std::vector<int>> callers(funcs.size());
+    std::vector<int> pending(funcs.size(), 0);
+    for (size_t i = 0; i < funcs.size(); i++) {
+        auto *func = static_cast<FuncDecl *>(program->items[funcs[i]]);
+        std::set<int> callees;
+        std::vector<AstNode *> stack = {func->body, func->ret};
+        while (!stack.empty()) {
+            AstNode *node = stack.back();
+            stack.pop_back();
+            if (node == nullptr) {
+                continue;
             }
-
-            if (stp_r != INT) {
-                std::cerr << RED
-                          << "Semantic Error [Line " << line_number << "]: "
-                          << "Right operand of comparison operator must be of type 'int'.\n"
-                          << "  - The right operand has type '" << semantic_type_to_string[stp_r]
-                          << "' which is not integer.\n"
-                          << "  - Ensure the right operand is an integer expression.\n"
-                          << WHITE << std::endl;
-                std::cerr << "----------------------------------------------------------------" << std::endl;
-                num_errors++;
+            if (node->kind == AST_CALL) {
+                int callee = symbol_table.find_function(static_cast<Call *>(node)->name);
+                if (callee >= 0 && generics.count(callee)) {
+                    serial.insert(func->symbol);
+                }
+                // a specialization is checked on the call, after the functions the generic one calls
+                if (callee >= 0 && callee != func->symbol &&
+                    (symbol_table[callee].get_stype() == UNK || generics.count(callee))) {
+                    callees.insert(order[callee]);
+                }
             }
+            get_ast_children(node, stack);
+        }
+        for (int callee: callees) {
+            callers[callee].push_back((int) i);
+        }
+        pending[i] = (int) callees.size();
+    }
 
-            // value
-            std::string left_val_str = node->get_parent()->get_children()[0]->get_data().get_val();
-            std::string right_val_str = children[1]->get_data().get_val();
-
-            if (!left_val_str.empty() && !right_val_str.empty()) {
-                long long left_val = std::stoll(left_val_str);
-                long long right_val = std::stoll(right_val_str);
-                std::string op_name = children[0]->get_children()[0]->get_data().get_name();
-                bool result = false;
-
-                if (op_name == "T_ROp_L") result = left_val < right_val;
-                else if (op_name == "T_ROp_LE") result = left_val <= right_val;
-                else if (op_name == "T_ROp_G") result = left_val > right_val;
-                else if (op_name == "T_ROp_GE") result = left_val >= right_val;
-                node->get_parent()->get_data().set_val(result ? "true" : "false");
+    std::vector<bool> scheduled(funcs.size(), false);
+    std::vector<int> ready;
+    for (size_t i = 0; i < funcs.size(); i++) {
+        if (pending[i] == 0) {
+            ready.push_back((int) i);
+            scheduled[i] = true;
+        }
+    }
+    size_t done = 0;
+    while (done < funcs.size()) {
+        if (ready.empty()) {
+            int first = (int) (std::find(scheduled.begin(), scheduled.end(), false) - scheduled.begin());
+            ready.push_back(first);
+            scheduled[first] = true;
+        }
+        waves.emplace_back();
+        std::vector<int> next;
+        for (int i: ready) {
+            waves.back().push_back(funcs[i]);
+            for (int caller: callers[i]) {
+                if (--pending[caller] == 0 && !scheduled[caller]) {
+                    next.push_back(caller);
+                    scheduled[caller] = true;
+                }
             }
         }
-    } else if (head_name == "arith_exp_tail" || head_name == "arith_term_tail") {
-        if (children[0]->get_data().get_name() != "eps") {
+        done += ready.size();
+        std::sort(next.begin(), next.end());
+        ready = std::move(next);
+    }
+}
 
-            Node<Symbol> *parent = node->get_parent();
-            std::string parent_name = parent->get_data().get_name();
-            Node<Symbol> *left_operand_node = nullptr;
+/*
+    Second pass: each body is checked on a worker with its own scope table and diagnostics. A
+    body calling a generic function adds specializations to the tables, so it is checked after
+    the workers of its wave are done.
+*/
+void SemanticAnalyzer::check_functions(std::vector<ItemCheck> &items, const std::vector<std::vector<int>> &waves) {
+    for (const auto &all: waves) {
+        std::vector<int> wave, in_order;
+        for (int id: all) {
+            int func = static_cast<FuncDecl *>(program->items[id])->symbol;
+            if (!generics.count(func)) {
+                (serial.count(func) ? in_order : wave).push_back(id);
+            }
+        }
 
-            if (parent_name == "arith_exp" || parent_name == "arith_term") {
-                left_operand_node = parent->get_children()[0];
-            } else {
-                // گرامر: <Op> <exp> <tail>
-                left_operand_node = parent->get_children()[1];
+        int num_bodies = (int) wave.size();
+        if (PARALLEL_SEMANTIC && num_bodies >= PARALLEL_MIN_BODIES) {
+            int num_threads = std::max(1, std::min((int) std::thread::hardware_concurrency(), num_bodies));
+            std::atomic<int> next(0);
+            std::vector<std::thread> workers;
+            for (int i = 0; i < num_threads; i++) {
+                workers.emplace_back([this, &items, &wave, &next, num_bodies]() {
+                    for (int id = next++; id < num_bodies; id = next++) {
+                        check_function(static_cast<FuncDecl *>(program->items[wave[id]]), items[wave[id]]);
+                    }
+                });
             }
+            for (auto &worker: workers) {
+                worker.join();
+            }
+        } else {
+            in_order.insert(in_order.end(), wave.begin(), wave.end());
+            std::sort(in_order.begin(), in_order.end());
+        }
+        for (int id: in_order) {
+            check_function(static_cast<FuncDecl *>(program->items[id]), items[id]);
+        }
+    }
+}
+
+// the functions called by func, and the other names it uses
+static void collect_names(FuncDecl *func, std::set<std::string> &calls, std::set<std::string> &names) {
+    std::vector<AstNode *> stack = {func->body, func->ret};
+    while (!stack.empty()) {
+        AstNode *node = stack.back();
+        stack.pop_back();
+        if (node == nullptr) {
+            continue;
+        }
+        if (node->kind == AST_CALL) {
+            calls.insert(static_cast<Call *>(node)->name);
+        } else if (node->kind == AST_NAME) {
+            names.insert(static_cast<Name *>(node)->name);
+        }
+        get_ast_children(node, stack);
+    }
+}
 
-            semantic_type stp_l = exp_t_to_semantic_type(left_operand_node->get_data().get_exp_type());
-            semantic_type stp_r = exp_t_to_semantic_type(children[1]->get_data().get_exp_type());
+// A folded call runs the callee and whatever it calls, so a pure function stands for all those bodies.
+void SemanticAnalyzer::hash_pure_functions(const std::vector<ItemCheck> &items) {
+    std::map<std::string, std::pair<FuncDecl *, uint64_t>> bodies;
+    for (size_t id = 0; id < program->items.size(); id++) {
+        if (program->items[id]->kind != AST_FUNC_DECL) {
+            continue;
+        }
+        auto *func = static_cast<FuncDecl *>(program->items[id]);
+        if (symbol_table.find_function(func->name) == func->symbol) {
+            bodies[func->name] = {func, items[id].hash};
+        }
+    }
 
-            if (stp_l != INT) {
-                std::cerr << RED
-                          << "Semantic Error [Line " << line_number << "]: "
-                          << "Left operand of arithmetic operator must be of type 'int'.\n"
-                          << "  - The left operand has type '" << semantic_type_to_string[stp_l]
-                          << "' which is not integer.\n"
-                          << "  - Ensure the left operand is an integer expression.\n"
-                          << WHITE << std::endl;
-                std::cerr << "----------------------------------------------------------------" << std::endl;
-                num_errors++;
+    for (const auto &body: bodies) {
+        if (!const_evaluator.is_pure(body.first)) {
+            continue;
+        }
+        std::set<std::string> reached = {body.first};
+        std::vector<std::string> stack = {body.first};
+        while (!stack.empty()) {
+            std::set<std::string> calls, names;
+            collect_names(bodies[stack.back()].first, calls, names);
+            stack.pop_back();
+            for (const auto &callee: calls) {
+                if (reached.insert(callee).second) {
+                    stack.push_back(callee);
+                }
             }
+        }
+        uint64_t hash = 0;
+        for (const auto &name: reached) {
+            hash = hash_string(std::to_string(bodies[name].second), hash);
+        }
+        pure_hashes[body.first] = hash;
+    }
+}
 
-            if (stp_r != INT) {
-                std::cerr << RED
-                          << "Semantic Error [Line " << line_number << "]: "
-                          << "Right operand of arithmetic operator must be of type 'int'.\n"
-                          << "  - The right operand has type '" << semantic_type_to_string[stp_r]
-                          << "' which is not integer.\n"
-                          << "  - Ensure the right operand is an integer expression.\n"
-                          << WHITE << std::endl;
-                std::cerr << "----------------------------------------------------------------" << std::endl;
-                num_errors++;
+// The body's hash with the signatures of the functions it calls and whether the names it uses are functions.
+uint64_t SemanticAnalyzer::function_key(FuncDecl *func, uint64_t hash) const {
+    std::set<std::string> calls, names;
+    collect_names(func, calls, names);
+    for (const auto &name: names) {
+        hash = hash_string(name + (symbol_table.find_function(name) < 0 ? " -" : " +"), hash);
+    }
+    for (const auto &name: calls) {
+        int callee = symbol_table.find_function(name);
+        std::string signature = name + " ";
+        if (callee >= 0) {
+            signature += type_table.to_string(symbol_table[callee].get_stype()) + " (";
+            for (const auto &param: symbol_table[callee].get_parameters()) {
+                signature += type_table.to_string(param.second) + ",";
             }
+            signature += ")";
+        }
+        auto pure = pure_hashes.find(name);
+        if (pure != pure_hashes.end()) {
+            signature += " " + std::to_string(pure->second);
         }
-    } else if (head_name == "type") {
-        if (children[0]->get_data().get_name() == "T_Int") symbol.set_stype(INT);
-        else if (children[0]->get_data().get_name() == "T_Bool") symbol.set_stype(BOOL);
-        else if (children[0]->get_data().get_name() == "T_LP") symbol.set_stype(TUPLE);
-        else if (children[0]->get_data().get_name() == "T_LB") symbol.set_stype(ARRAY);
-    } else if (head_name == "opt_type") {
-        if (children[0]->get_data().get_name() == "T_Int") symbol.set_stype(INT);
-        else if (children[0]->get_data().get_name() == "T_Bool") symbol.set_stype(BOOL);
-        else if (children[0]->get_data().get_name() == "T_LP") symbol.set_stype(TUPLE);
-        else if (children[0]->get_data().get_name() == "T_LB") symbol.set_stype(ARRAY);
-        else if (children[0]->get_data().get_name() == "eps") symbol.set_stype(VOID);
+        hash = hash_string(signature, hash);
     }
+    return hash;
+}
 
-    if (is_new_scope) {
-//        std::vector<std::string> keys_to_erase;
-//        if (!current_func.empty() && !(current_func == "main")) {
-//            for (const auto &[key, val]: symbol_table[current_func]) {
-//                if (val.get_def_area() == def_area) {
-//                    keys_to_erase.push_back(key);
-//                }
-//            }
-//            for (const auto &key: keys_to_erase) {
-//                symbol_table[current_func].erase(key);
-//            }
-//        }
-
-        if (head_name == "func") {
-            current_func = "";
-        }
-        def_area--;
+void SemanticAnalyzer::check_function(FuncDecl *func, ItemCheck &item) {
+    ItemCheck checked;
+    uint64_t key = 0;
+    const std::string *record = nullptr;
+    bool caching = SEMANTIC_CACHE && !cache_address.empty() && !serial.count(func->symbol);
+    if (caching) {
+        key = function_key(func, item.hash);
+        record = cache.find(key);
     }
+
+    if (record != nullptr && SemanticCache::decode(*record, func, checked, symbol_table, type_table)) {
+        cache.store(key, *record);
+        item.cached = true;
+    } else {
+        BodyChecker checker(*this);
+        checker.analyze_function(func);
+        checked.diagnostics = std::move(checker.diagnostics);
+        if (caching) {
+            cache.store(key, SemanticCache::encode(func, checked, symbol_table, type_table));
+        }
+    }
+
+    // the redeclaration found in the first pass comes before the body's reports
+    item.diagnostics.insert(item.diagnostics.end(), checked.diagnostics.begin(), checked.diagnostics.end());
 }
 
-void SemanticAnalyzer::check_for_main_function() {
+// f_i32_bool, with f_a3_i32 for [i32; 3] and f_t2_i32_bool for (i32, bool)
+static std::string mangle_type(const TypeTable &types, type_id type) {
+    const TypeInfo &info = types[type];
+    switch (info.kind) {
+        case INT:
+            return "i32";
+        case BOOL:
+            return "bool";
+        case ARRAY:
+            return "a" + std::to_string(info.length) + "_" + mangle_type(types, info.element);
+        case TUPLE: {
+            std::string name = "t" + std::to_string(info.elements.size());
+            for (auto element: info.elements) {
+                name += "_" + mangle_type(types, element);
+            }
+            return name;
+        }
+        default:
+            return "unk";
+    }
+}
 
-    if (symbol_table[""].count("main") == 0) {
-        std::cerr << RED
-                  << "Semantic Error: No 'main' function found.\n"
-                  << "  - Every program must have a 'main' function as the entry point.\n"
-                  << WHITE << std::endl;
-        std::cerr << "----------------------------------------------------------------" << std::endl;
-        num_errors++;
+/*
+    The function a call of a generic one with these argument types goes to. The first
+    combination of types is given to the generic function itself, every later one to a copy
+    named after its parameter types, each checked as soon as it is made. A combination seen
+    before, including one still being checked for a recursive call, reuses its function.
+    Past MAX_SPECIALIZATIONS the calls go to the first one and mismatches are reported.
+*/
+int SemanticAnalyzer::specialize(int func, const std::vector<type_id> &args) {
+    Generic &generic = generics.at(func);
+    std::vector<type_id> params = generic.params;
+    for (size_t i = 0; i < params.size(); i++) {
+        params[i] = params[i] == UNK ? args[i] : params[i];
     }
+    auto found = instances.find({func, params});
+    if (found != instances.end()) {
+        return found->second;
+    }
+    if (generic.num_instances >= MAX_SPECIALIZATIONS) {
+        return func;
+    }
+
+    FuncDecl *decl = generic.func;
+    int instance = func;
+    if (generic.num_instances > 0) {
+        std::string name = generic.func->name;
+        for (auto param: params) {
+            name += "_" + mangle_type(type_table, param);
+        }
+        while (symbol_table.find_function(name) >= 0) {
+            name += "_";
+        }
+        SymbolTableEntry entry(FUNC);
+        entry.set_name(name);
+        entry.set_stype(generic.ret);
+        for (size_t i = 0; i < params.size(); i++) {
+            entry.add_to_parameters({generic.func->params[i]->name, params[i]});
+        }
+        decl = static_cast<FuncDecl *>(clone_ast(generic.func, arena));
+        decl->symbol = instance = symbol_table.add_function(name, entry);
+        clones[func].push_back(decl);
+    } else {
+        for (size_t i = 0; i < params.size(); i++) {
+            symbol_table[func].get_parameters()[i].second = params[i];
+        }
+    }
+    generic.num_instances++;
+    instances[{func, params}] = instance;
+
+    BodyChecker checker(*this);
+    checker.analyze_function(decl);
+    instance_diagnostics.insert(instance_diagnostics.end(), checker.diagnostics.begin(), checker.diagnostics.end());
+    return instance;
+}
+
+// the copies of a generic function follow it, so they are annotated and generated with it
+void SemanticAnalyzer::insert_clones() {
+    std::vector<AstNode *> items;
+    for (auto item: program->items) {
+        items.push_back(item);
+        if (item->kind == AST_FUNC_DECL && clones.count(static_cast<FuncDecl *>(item)->symbol)) {
+            const std::vector<FuncDecl *> &copies = clones[static_cast<FuncDecl *>(item)->symbol];
+            items.insert(items.end(), copies.begin(), copies.end());
+        }
+    }
+    program->items = std::move(items);
 }
 
 void SemanticAnalyzer::analyze() {
-    if (parse_tree.get_root() != nullptr) {
-        dfs(parse_tree.get_root());
+    std::vector<ItemCheck> items(program->items.size());
+    std::vector<std::vector<int>> waves;
+    bool caching = SEMANTIC_CACHE && !cache_address.empty();
+    if (caching) {
+        cache.load(cache_address);
+    }
+    collect_signatures(items, waves);
+    check_functions(items, waves);
+    if (caching) {
+        int num_bodies = 0, num_cached = 0;
+        for (size_t id = 0; id < items.size(); id++) {
+            num_bodies += program->items[id]->kind == AST_FUNC_DECL;
+            num_cached += items[id].cached;
+        }
+        if (num_cached > 0) {
+            std::cout << "Reused the checks of " << num_cached << " of " << num_bodies << " function(s) from "
+                      << cache_address << std::endl;
+        }
+        if (!cache.save(cache_address)) {
+            std::cerr << RED << "File Error: Couldn't write semantic cache file '" << cache_address << "'" << WHITE
+                      << std::endl;
+        }
     }
 
+    // statements outside functions see the final signatures and are checked in order
+    for (size_t id = 0; id < program->items.size(); id++) {
+        if (program->items[id]->kind != AST_FUNC_DECL) {
+            BodyChecker checker(*this);
+            checker.dfs(program->items[id]);
+            items[id].diagnostics = std::move(checker.diagnostics);
+        }
+    }
+
+    // a generic function nothing calls is checked once with its parameters unknown
+    for (auto &generic: generics) {
+        if (generic.second.num_instances == 0) {
+            specialize(generic.first, generic.second.params);
+        }
+    }
+    insert_clones();
+
+    DiagnosticEngine engine;
+    engine.max_errors = max_errors;
+    engine.format = diagnostic_format;
+    for (auto &item: items) {
+        engine.add(std::move(item.diagnostics));
+    }
+    engine.add(std::move(instance_diagnostics));
     check_for_main_function();
+    engine.add(std::move(diagnostics));
+    int num_errors = engine.finish();
+    if (num_errors > 0 || diagnostic_format == DIAG_JSON) {
+        engine.emit(std::cerr);
+    }
 
     if (num_errors == 0) {
         std::cout << GREEN << "Semantic analysis completed with no errors." << WHITE << std::endl;
@@ -1085,8 +1032,7 @@ void SemanticAnalyzer::analyze() {
             std::cerr << RED << "File Error: Couldn't open semantic output file '" << out_address << "'" << WHITE
                       << std::endl;
         } else {
-            std::fill(has_par, has_par + 200, false);
-            write_annotated_tree(parse_tree.get_root());
+            write_annotated_tree(out);
             out.close();
             std::cout << "Annotated syntax tree written to " << out_address << std::endl;
         }
@@ -1096,81 +1042,76 @@ void SemanticAnalyzer::analyze() {
     }
 }
 
-void SemanticAnalyzer::write_annotated_tree(Node<Symbol> *node, int num, bool last) {
-    if (!node) return;
-
-    Symbol &var = node->get_data();
-
-    for (int i = 0; i < num * 4 - 4; i++) {
-        if (has_par[i]) {
-            out << "│";
-        } else {
-            out << " ";
+void SemanticAnalyzer::write_annotated_tree(std::ostream &stream) {
+    OutputSink sink(stream);
+    // handles inside a function refer to its scope table, the ones in top-level statements to the global one
+    const SymbolTable *scope = &symbol_table;
+    std::set<AstNode *> statements;
+    for (auto item: program->items) {
+        if (item->kind != AST_FUNC_DECL) {
+            statements.insert(item);
         }
     }
-    if (num > 0) {
-        out << (last ? "└── " : "├── ");
-    }
-
-    out << var;
-
-    std::vector<std::string> annotations;
-    std::string name = var.get_name();
-    std::string content = var.get_content();
-    semantic_type stype_from_table = UNK;
-
-    if (name == "T_Id") {
-        if (symbol_table.count(current_func) && symbol_table[current_func].count(content)) {
-            stype_from_table = symbol_table[current_func][content].get_stype();
-        } else if (symbol_table[""].count(content)) {
-            stype_from_table = symbol_table[""][content].get_stype(); // For functions
-        }
-        if (stype_from_table != UNK) {
-            annotations.push_back("type: " + semantic_type_to_string[stype_from_table]);
+    auto describe = [this, &scope, &statements](AstNode *node, TreeLabel &label) {
+        label.name = ast_to_string(node);
+        label.line = node->line;
+        if (statements.count(node)) {
+            scope = &symbol_table;
         }
-    }
-
-    exp_type et = var.get_exp_type();
-    if (et != TYPE_UNKNOWN && et != TYPE_VOID) {
-        annotations.push_back("exp_type: " + exp_t_to_string(et));
-    }
-
-    std::string val = var.get_val();
-    if (!val.empty()) {
-        annotations.push_back("val: '" + val + "'");
-    }
 
-    if (var.get_type() == TERMINAL && !content.empty()) {
-        annotations.push_back("content: '" + content + "'");
-    }
-
-    if (!annotations.empty()) {
-        out << "  [ ";
-        for (size_t i = 0; i < annotations.size(); ++i) {
-            out << annotations[i] << (i == annotations.size() - 1 ? "" : ", ");
+        int handle = -1;
+        switch (node->kind) {
+            case AST_FUNC_DECL: {
+                int func = static_cast<FuncDecl *>(node)->symbol;
+                label.notes.push_back("type: " + type_table.to_string(symbol_table[func].get_stype()));
+                scope = &symbol_table.get_locals(func);
+                break;
+            }
+            case AST_PARAM:
+                handle = static_cast<Param *>(node)->symbol;
+                break;
+            case AST_LET:
+                if (!static_cast<Let *>(node)->tuple_pattern && !static_cast<Let *>(node)->symbols.empty()) {
+                    handle = static_cast<Let *>(node)->symbols[0];
+                }
+                break;
+            case AST_NAME:
+                handle = static_cast<Name *>(node)->symbol;
+                break;
+            default:
+                break;
+        }
+        if (handle >= 0) {
+            type_id stype_from_table = (*scope)[handle].get_stype();
+            if (stype_from_table != UNK) {
+                label.notes.push_back("type: " + type_table.to_string(stype_from_table));
+            }
         }
-        out << " ]";
-    }
-
-    out << std::endl;
 
-    has_par[num * 4] = true;
-    std::deque<Node<Symbol> *> children = node->get_children();
-    for (auto it = children.begin(); it != children.end(); ++it) {
-        bool is_last_child = (std::next(it) == children.end());
-        if (is_last_child) {
-            has_par[num * 4] = false;
+        if (node->kind >= AST_BINARY) {
+            auto *exp = static_cast<Expr *>(node);
+            if (exp->exp_t != TYPE_UNKNOWN && exp->exp_t != TYPE_VOID) {
+                label.notes.push_back("exp_type: " + exp_t_to_string(exp->exp_t));
+            }
+            if (exp->constant.known()) {
+                label.notes.push_back("val: '" + exp->constant.to_string() + "'");
+            }
         }
-        write_annotated_tree(*it, num + 1, is_last_child);
-    }
+    };
+    print_tree(sink, (AstNode *) program, format, describe, get_ast_children);
 }
 
-SemanticAnalyzer::SemanticAnalyzer(Tree<Symbol>
-                                   _parse_tree, std::string
-                                   output_file_name) {
-    parse_tree = _parse_tree;
+SemanticAnalyzer::SemanticAnalyzer(Program *_program, std::string output_file_name) {
+    program = _program;
     out_address = std::move(output_file_name);
-    def_area = 0;
-    current_func = "";
-    num_errors = 0;
-}
\ No newline at end of file
+    format = TREE_BOX;
+    max_errors = INT_MAX;
+    diagnostic_format = DIAG_TEXT;
+}
+
+BodyChecker::BodyChecker(SemanticAnalyzer &_owner) : owner(_owner) {
+    globals = &owner.symbol_table;
+    types = &owner.type_table;
+    evaluator = &owner.const_evaluator;
+    locals = globals;
+}
@@ -4,187 +4,133 @@
 #include <utility>
 
 #include "../utils.h"
-
-enum id_type {
-    VAR,
-    FUNC,
-    NONE
+#include "../SyntaxAnalyzer/ast.h"
+#include "symbol_table.h"
+#include "type_table.h"
+#include "const_evaluator.h"
+#include "semantic_cache.h"
+#include "diagnostics.h"
+
+#define PARALLEL_SEMANTIC true
+#define PARALLEL_MIN_BODIES 2
+#define SEMANTIC_CACHE true
+#define MAX_SPECIALIZATIONS 16
+
+// a function with untyped parameters, checked once for every combination of argument types it's called with
+struct Generic {
+    FuncDecl *func;
+    std::vector<type_id> params;  // the declared types, UNK where none is given
+    type_id ret;                  // the return type its signature gives
+    int num_instances = 0;
 };
 
-class SymbolTableEntry {
-private:
-    std::string name;
-    id_type type;
-    semantic_type stype;
-    std::vector<std::pair<std::string, semantic_type>> parameters;
-    std::vector<semantic_type> tuple_types;
-    int def_area;
-    bool mut;
-    std::string val;
-
-    int arr_len;
-    semantic_type arr_type;
-
-public:
-    SymbolTableEntry() {
-        type = NONE;
-        val = "";
-    }
-
-    SymbolTableEntry(id_type _type) {
-        type = _type;
-        stype = UNK;
-        def_area = 0;
-        mut = false;
-        arr_len = 0;
-        arr_type = UNK;
-        val = "";
-    }
-
-    SymbolTableEntry(id_type _type, semantic_type _stype, int _def_area, bool _mut = false,
-                     int _arr_len = 0, semantic_type _arr_type = UNK) {
-        type = _type;
-        stype = _stype;
-        def_area = _def_area;
-        mut = _mut;
-        arr_len = _arr_len;
-        arr_type = _arr_type;
-        val = "";
-    }
-
-
-    void set_name(std::string _name) {
-        name = std::move(_name);
-    }
-
-    std::string get_name() const {
-        return name;
-    }
+class SemanticAnalyzer;
 
-    void set_type(id_type _type) {
-        type = _type;
-    }
+/*
+    Checks one function body, or a statement outside functions, against the tables of the
+    analyzer of the whole program. It only holds the scope it is in and its reports, so every
+    body a worker checks and every specialization gets a fresh one.
+*/
+class BodyChecker {
+private:
+    SemanticAnalyzer &owner;
+    SymbolTable *globals;
+    TypeTable *types;
+    const ConstEvaluator *evaluator;
+    SymbolTable *locals;
+    std::string current_func;
 
-    id_type get_type() {
-        return type;
-    }
+    void report(diag_code code, int line_number, std::vector<std::string> args = {});
 
-    void set_stype(semantic_type _stype) {
-        stype = _stype;
-    }
+    void check_identifier(const std::string &name, int line_number);
 
-    semantic_type get_stype() {
-        return stype;
-    }
+    void analyze_let(Let *let);
 
-    void add_to_parameters(std::pair<std::string, semantic_type> parameter) {
-        parameters.push_back(parameter);
-    }
+    void analyze_assign(Assign *assign);
 
-    std::vector<std::pair<std::string, semantic_type>> &get_parameters() {
-        return parameters;
-    }
+    void analyze_index_assign(IndexAssign *assign);
 
-    void set_val(std::string _val) {
-        val = std::move(_val);
-    }
+    void analyze_if(If *if_stmt);
 
-    std::string get_val() {
-        return val;
-    }
+    void analyze_call(Call *call);
 
-    void add_to_tuple_types(semantic_type _stype) {
-        tuple_types.push_back(_stype);
-    }
+    void analyze_index(Index *index);
 
-    void add_to_tuple_types(std::vector<semantic_type> &_tuple_types) {
-        for (auto _stype: _tuple_types) {
-            tuple_types.push_back(_stype);
-        }
-    }
+    void analyze_binary(Binary *binary);
 
-    std::vector<semantic_type> &get_tuple_types() {
-        return tuple_types;
-    }
+    void analyze_unary(Unary *unary);
 
-    void set_def_area(int _def_area) {
-        def_area = _def_area;
-    }
+public:
+    std::vector<Diagnostic> diagnostics;
 
-    int get_def_area() const {
-        return def_area;
-    }
+    explicit BodyChecker(SemanticAnalyzer &_owner);
 
-    void set_mut(bool _mut) {
-        mut = _mut;
-    }
+    void dfs(AstNode *node);
 
-    bool get_mut() {
-        return mut;
-    }
+    void analyze_function(FuncDecl *func);
+};
 
-    void set_arr_len(int _arr_len) {
-        arr_len = _arr_len;
-    }
+class SemanticAnalyzer {
+private:
+    friend class BodyChecker;
 
-    int get_arr_len() {
-        return arr_len;
-    }
+    std::string out_address;
+    Program *program;
+    std::ofstream out;
 
-    void set_arr_type(semantic_type _arr_type) {
-        arr_type = _arr_type;
-    }
+    // functions and top-level variables, a function body is checked in its own scope table
+    SymbolTable symbol_table;
+    TypeTable type_table;
+    ConstEvaluator const_evaluator;
+    SemanticCache cache;
+    std::map<std::string, uint64_t> pure_hashes;
+    std::vector<Diagnostic> diagnostics;  // the ones about the whole program
+
+    std::map<int, Generic> generics;
+    std::map<std::pair<int, std::vector<type_id>>, int> instances;
+    std::map<int, std::vector<FuncDecl *>> clones;  // the copies of a generic function, allocated in arena
+    std::set<int> serial;  // functions calling a generic one, checked on the main thread
+    std::vector<Diagnostic> instance_diagnostics;
+    Arena arena;
 
-    semantic_type get_arr_type() {
-        return arr_type;
-    }
+    std::string code;
 
-    void clear_parameters() {
-        parameters.clear();
-    }
+    void collect_signatures(std::vector<ItemCheck> &items, std::vector<std::vector<int>> &waves);
 
-    semantic_type get_stype() const {
-        return stype;
-    }
+    void check_functions(std::vector<ItemCheck> &items, const std::vector<std::vector<int>> &waves);
 
-    const std::vector<std::pair<std::string, semantic_type>>& get_parameters() const {
-        return parameters;
-    }
+    void hash_pure_functions(const std::vector<ItemCheck> &items);
 
-    const std::vector<semantic_type>& get_tuple_types() const {
-        return tuple_types;
-    }
-};
+    uint64_t function_key(FuncDecl *func, uint64_t hash) const;
 
-class SemanticAnalyzer {
-private:
-    std::string out_address;
-    Tree<Symbol> parse_tree;
-    std::ofstream out;
-    bool has_par[200]{};
+    void check_function(FuncDecl *func, ItemCheck &item);
 
-    std::map<std::string, std::map<std::string, SymbolTableEntry>> symbol_table;
+    int specialize(int func, const std::vector<type_id> &args);
 
-    int def_area;
-    std::string current_func;
-    std::string code;
-    int num_errors;
+    void insert_clones();
 
-    void write_annotated_tree(Node<Symbol> *node, int num = 0, bool last = false);
+    void write_annotated_tree(std::ostream &stream);
 
 public:
-    void dfs(Node<Symbol> *node);
+    tree_format format;
+    std::string cache_address;  // checked bodies are kept here between runs, empty to check them all
+    int max_errors;             // reports shown, the rest are only counted
+    diag_format diagnostic_format;
 
     void check_for_main_function();
 
     void analyze();
 
-    SemanticAnalyzer(Tree<Symbol> _parse_tree, std::string output_file_name);
+    SemanticAnalyzer(Program *_program, std::string output_file_name);
 
-    std::map<std::string, std::map<std::string, SymbolTableEntry>> get_symbol_table() {
+    const SymbolTable &get_symbol_table() const {
         return symbol_table;
     }
 
+    const TypeTable &get_type_table() const {
+        return type_table;
+    }
+
 };
 
-#endif // SEMANTIC_ANALYZER_H
\ No newline at end of file
+#endif // SEMANTIC_ANALYZER_H
@@ -0,0 +1,353 @@
+#include "semantic_cache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+
+class RecordWriter {
+public:
+    std::string buffer;
+
+    void put(uint64_t value, size_t size = sizeof(uint32_t)) {
+        buffer.append((const char *) &value, size);
+    }
+
+    void put_string(const std::string &text) {
+        put(text.size());
+        buffer += text;
+    }
+
+    // the ids below UNK+1 are the same in every run, the others are written by structure
+    void put_type(const TypeTable &types, type_id type) {
+        const TypeInfo &info = types[type];
+        if (type <= UNK) {
+            put(type);
+        } else if (info.kind == ARRAY) {
+            put(UNK + 1);
+            put_type(types, info.element);
+            put((uint32_t) info.length);
+        } else {
+            put(UNK + 2);
+            put(info.elements.size());
+            for (type_id element: info.elements) {
+                put_type(types, element);
+            }
+        }
+    }
+
+    void put_constant(const ConstValue &constant) {
+        put(constant.kind);
+        put((uint32_t) constant.number);
+        put(constant.elements.size());
+        for (const auto &element: constant.elements) {
+            put_constant(element);
+        }
+    }
+};
+
+class RecordReader {
+private:
+    const std::string &buffer;
+    size_t pos;
+
+public:
+    bool ok;
+
+    explicit RecordReader(const std::string &_buffer) : buffer(_buffer), pos(0), ok(true) {}
+
+    bool done() const {
+        return ok && pos == buffer.size();
+    }
+
+    uint64_t get(size_t size = sizeof(uint32_t)) {
+        uint64_t value = 0;
+        ok = ok && pos + size <= buffer.size();
+        if (ok) {
+            memcpy(&value, buffer.data() + pos, size);
+            pos += size;
+        }
+        return value;
+    }
+
+    // a count of items that each take at least four bytes, 0 if it runs past the end
+    size_t get_count() {
+        size_t count = get();
+        ok = ok && count <= (buffer.size() - pos) / sizeof(uint32_t);
+        return ok ? count : 0;
+    }
+
+    std::string get_string() {
+        size_t size = get();
+        ok = ok && size <= buffer.size() - pos;
+        if (!ok) {
+            return "";
+        }
+        pos += size;
+        return buffer.substr(pos - size, size);
+    }
+
+    type_id get_type(TypeTable &types) {
+        uint32_t tag = get();
+        if (tag <= UNK) {
+            return tag;
+        }
+        if (tag == UNK + 1) {
+            type_id element = get_type(types);
+            int length = (int) get();
+            return ok ? types.array(element, length) : (type_id) UNK;
+        }
+        std::vector<type_id> elements(get_count());
+        for (auto &element: elements) {
+            element = get_type(types);
+        }
+        ok = ok && tag == UNK + 2;
+        return ok ? types.tuple(elements) : (type_id) UNK;
+    }
+
+    ConstValue get_constant() {
+        ConstValue constant;
+        constant.kind = (const_kind) get();
+        constant.number = (int32_t) get();
+        constant.elements.resize(get_count());
+        for (auto &element: constant.elements) {
+            element = get_constant();
+        }
+        ok = ok && constant.kind <= CONST_TUPLE;
+        return constant;
+    }
+};
+
+// the nodes of a function below its declaration, in the same order on every run
+static std::vector<AstNode *> function_nodes(FuncDecl *func) {
+    std::vector<AstNode *> nodes, stack;
+    get_ast_children(func, stack);
+    while (!stack.empty()) {
+        AstNode *node = stack.back();
+        stack.pop_back();
+        nodes.push_back(node);
+        get_ast_children(node, stack);
+    }
+    return nodes;
+}
+
+uint64_t SemanticCache::hash_function(FuncDecl *func) {
+    uint64_t hash = hash_string(ast_to_string(func));
+    std::vector<AstNode *> children;
+    for (AstNode *node: function_nodes(func)) {
+        children.clear();
+        get_ast_children(node, children);
+        int token = node->kind == AST_LITERAL ? static_cast<Literal *>(node)->token : -1;
+        hash = hash_string(ast_to_string(node), hash);
+        hash = hash_string(std::to_string(node->line - func->line) + " " + std::to_string(children.size()) + " " +
+                           std::to_string(token), hash);
+    }
+    return hash;
+}
+
+std::string SemanticCache::encode(FuncDecl *func, const ItemCheck &item, const SymbolTable &globals,
+                                  const TypeTable &types) {
+    RecordWriter out;
+    out.put(func->line);
+    out.put(item.diagnostics.size());
+    for (const auto &diagnostic: item.diagnostics) {
+        out.put(diagnostic.code);
+        out.put(diagnostic.line);
+        out.put(diagnostic.args.size());
+        for (const auto &arg: diagnostic.args) {
+            out.put_string(arg);
+        }
+    }
+    out.put_type(types, globals[func->symbol].get_stype());
+
+    const std::deque<SymbolTableEntry> &entries = globals.get_locals(func->symbol).get_entries();
+    out.put(entries.size());
+    for (const auto &entry: entries) {
+        out.put_string(entry.get_name());
+        out.put_type(types, entry.get_stype());
+        out.put(entry.get_def_area());
+        out.put(entry.get_mut());
+        out.put_constant(entry.get_constant());
+    }
+
+    for (AstNode *node: function_nodes(func)) {
+        if (node->kind >= AST_BINARY) {
+            auto *exp = static_cast<Expr *>(node);
+            out.put(exp->exp_t);
+            out.put_type(types, exp->type);
+            out.put_constant(exp->constant);
+        }
+        if (node->kind == AST_NAME) {
+            out.put(static_cast<Name *>(node)->symbol);
+        } else if (node->kind == AST_PARAM) {
+            out.put(static_cast<Param *>(node)->symbol);
+        } else if (node->kind == AST_LET) {
+            out.put(static_cast<Let *>(node)->symbols.size());
+            for (int symbol: static_cast<Let *>(node)->symbols) {
+                out.put(symbol);
+            }
+        }
+    }
+    return out.buffer;
+}
+
+bool SemanticCache::decode(const std::string &record, FuncDecl *func, ItemCheck &item, SymbolTable &globals,
+                           TypeTable &types) {
+    struct Annotation {
+        exp_type exp_t;
+        type_id type;
+        ConstValue constant;
+        std::vector<int> symbols;
+    };
+
+    // everything is read before anything is applied, so a damaged record changes nothing
+    RecordReader in(record);
+    int line = (int) in.get();
+    std::vector<Diagnostic> diagnostics(in.get_count());
+    for (auto &diagnostic: diagnostics) {
+        diagnostic.code = (diag_code) in.get();
+        diagnostic.line = (int) in.get();
+        diagnostic.args.resize(in.get_count());
+        for (auto &arg: diagnostic.args) {
+            arg = in.get_string();
+        }
+        in.ok = in.ok && diagnostic.code < DIAG_COUNT;
+    }
+    type_id return_type = in.get_type(types);
+
+    std::vector<SymbolTableEntry> entries(in.get_count());
+    for (auto &entry: entries) {
+        entry.set_type(VAR);
+        entry.set_name(in.get_string());
+        entry.set_stype(in.get_type(types));
+        entry.set_def_area((int) in.get());
+        entry.set_mut(in.get() != 0);
+        entry.set_constant(in.get_constant());
+    }
+    auto valid_symbol = [&entries](int symbol) {
+        return symbol >= -1 && symbol < (int) entries.size();
+    };
+
+    std::vector<AstNode *> nodes = function_nodes(func);
+    std::vector<Annotation> annotations(nodes.size());
+    for (size_t i = 0; i < nodes.size() && in.ok; i++) {
+        if (nodes[i]->kind >= AST_BINARY) {
+            annotations[i].exp_t = (exp_type) in.get();
+            annotations[i].type = in.get_type(types);
+            annotations[i].constant = in.get_constant();
+        }
+        if (nodes[i]->kind == AST_NAME || nodes[i]->kind == AST_PARAM) {
+            annotations[i].symbols.push_back((int) in.get());
+        } else if (nodes[i]->kind == AST_LET) {
+            annotations[i].symbols.resize(in.get_count());
+            for (int &symbol: annotations[i].symbols) {
+                symbol = (int) in.get();
+            }
+        }
+        for (int symbol: annotations[i].symbols) {
+            in.ok = in.ok && valid_symbol(symbol);
+        }
+    }
+    if (!in.done()) {
+        return false;
+    }
+
+    for (auto &diagnostic: diagnostics) {
+        diagnostic.line += func->line - line;
+    }
+    item.diagnostics = std::move(diagnostics);
+
+    SymbolTable &locals = globals.get_locals(func->symbol);
+    locals.push_scope();
+    for (const auto &entry: entries) {
+        locals.declare(entry.get_name(), entry);
+    }
+    locals.pop_scope();
+    if (globals[func->symbol].get_stype() == UNK) {
+        globals[func->symbol].set_stype(return_type);
+    }
+
+    for (size_t i = 0; i < nodes.size(); i++) {
+        if (nodes[i]->kind >= AST_BINARY) {
+            auto *exp = static_cast<Expr *>(nodes[i]);
+            exp->exp_t = annotations[i].exp_t;
+            exp->type = annotations[i].type;
+            exp->constant = std::move(annotations[i].constant);
+        }
+        if (nodes[i]->kind == AST_NAME) {
+            static_cast<Name *>(nodes[i])->symbol = annotations[i].symbols[0];
+        } else if (nodes[i]->kind == AST_PARAM) {
+            static_cast<Param *>(nodes[i])->symbol = annotations[i].symbols[0];
+        } else if (nodes[i]->kind == AST_LET) {
+            static_cast<Let *>(nodes[i])->symbols = annotations[i].symbols;
+        }
+    }
+    return true;
+}
+
+/*
+    File layout: magic, version, the number of records and a hash of what follows, then per
+    record its key, its size and its bytes.
+*/
+bool SemanticCache::load(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    RecordReader in(data);
+    uint32_t magic = in.get(), version = in.get();
+    size_t count = in.get();
+    uint64_t checksum = in.get(sizeof(uint64_t));
+    if (!in.ok || magic != CACHE_MAGIC || version != CACHE_VERSION ||
+        hash_string(data.substr(3 * sizeof(uint32_t) + sizeof(uint64_t))) != checksum) {
+        return false;
+    }
+
+    std::unordered_map<uint64_t, std::string> loaded;
+    for (size_t i = 0; i < count && in.ok; i++) {
+        uint64_t key = in.get(sizeof(uint64_t));
+        loaded[key] = in.get_string();
+    }
+    if (!in.done()) {
+        return false;
+    }
+    records = std::move(loaded);
+    return true;
+}
+
+// only this run's records are written, so the file holds no body that is gone
+bool SemanticCache::save(const std::string &path) const {
+    RecordWriter body;
+    for (const auto &record: current) {
+        body.put(record.first, sizeof(uint64_t));
+        body.put_string(record.second);
+    }
+    RecordWriter out;
+    out.put(CACHE_MAGIC);
+    out.put(CACHE_VERSION);
+    out.put(current.size());
+    out.put(hash_string(body.buffer), sizeof(uint64_t));
+
+    std::string tmp_path = path + ".tmp." + std::to_string(getpid());
+    std::ofstream file(tmp_path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    file << out.buffer << body.buffer;
+    file.close();
+    if (!file || std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+const std::string *SemanticCache::find(uint64_t key) const {
+    auto record = records.find(key);
+    return record == records.end() ? nullptr : &record->second;
+}
+
+void SemanticCache::store(uint64_t key, std::string record) {
+    std::lock_guard<std::mutex> guard(lock);
+    current[key] = std::move(record);
+}
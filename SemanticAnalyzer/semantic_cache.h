@@ -0,0 +1,61 @@
+#ifndef SEMANTIC_CACHE_H
+#define SEMANTIC_CACHE_H
+
+#include <mutex>
+#include <unordered_map>
+
+#include "../utils.h"
+#include "../SyntaxAnalyzer/ast.h"
+#include "symbol_table.h"
+#include "type_table.h"
+#include "diagnostics.h"
+
+#define CACHE_MAGIC 0x43534D54U // "TMSC"
+#define CACHE_VERSION 3
+
+// what checking one top-level item produced, merged in source order
+struct ItemCheck {
+    std::vector<Diagnostic> diagnostics;
+    uint64_t hash = 0;  // the function's tree, without the signatures it uses
+    bool cached = false;
+};
+
+/*
+    Persistent store of checked function bodies. A record holds everything checking a body
+    leaves behind: its diagnostics, its scope table, its return type and the annotations of
+    its nodes in preorder. Records are keyed by the hash
+    of the body together with the signatures of the functions it names, so a body is checked
+    again only when it or one of those signatures changed.
+
+    Lines are hashed relative to the function, so a body that only moved reuses its record
+    with the lines of its diagnostics shifted. Types and values are written by
+    structure, as type ids differ between runs. A body calling a function with untyped
+    parameters is always checked, as checking it adds the specializations it calls.
+*/
+class SemanticCache {
+private:
+    std::unordered_map<uint64_t, std::string> records;  // loaded from the file
+    std::unordered_map<uint64_t, std::string> current;  // this run's, written back
+    std::mutex lock;
+
+public:
+    static uint64_t hash_function(FuncDecl *func);
+
+    bool load(const std::string &path);
+
+    bool save(const std::string &path) const;
+
+    // a thread-safe lookup, nullptr if the key is unknown
+    const std::string *find(uint64_t key) const;
+
+    void store(uint64_t key, std::string record);
+
+    static std::string encode(FuncDecl *func, const ItemCheck &item, const SymbolTable &globals,
+                              const TypeTable &types);
+
+    // applies a record to a body with the same hash, false if the record is damaged
+    static bool decode(const std::string &record, FuncDecl *func, ItemCheck &item, SymbolTable &globals,
+                       TypeTable &types);
+};
+
+#endif // SEMANTIC_CACHE_H
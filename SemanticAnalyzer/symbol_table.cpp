@@ -0,0 +1,108 @@
+#include "symbol_table.h"
+
+void IdMap::grow() {
+    std::vector<uint32_t> old_keys = std::move(keys);
+    std::vector<int> old_values = std::move(values);
+    keys.assign(old_keys.size() * 2, NO_NAME);
+    values.assign(old_values.size() * 2, -1);
+    for (size_t i = 0; i < old_keys.size(); i++) {
+        if (old_keys[i] != NO_NAME) {
+            size_t j = home(old_keys[i]);
+            while (keys[j] != NO_NAME) {
+                j = (j + 1) & (keys.size() - 1);
+            }
+            keys[j] = old_keys[i];
+            values[j] = old_values[i];
+        }
+    }
+}
+
+int &IdMap::slot(uint32_t key) {
+    // keep the load factor under 3/4 so probe chains stay short
+    if ((count + 1) * 4 > keys.size() * 3) {
+        grow();
+    }
+    size_t i = home(key);
+    while (keys[i] != key && keys[i] != NO_NAME) {
+        i = (i + 1) & (keys.size() - 1);
+    }
+    if (keys[i] == NO_NAME) {
+        keys[i] = key;
+        values[i] = -1;
+        count++;
+    }
+    return values[i];
+}
+
+void Interner::grow() {
+    slots.assign(slots.size() * 2, 0);
+    for (uint32_t id = 0; id < names.size(); id++) {
+        size_t i = hashes[id] & (slots.size() - 1);
+        while (slots[i] != 0) {
+            i = (i + 1) & (slots.size() - 1);
+        }
+        slots[i] = id + 1;
+    }
+}
+
+uint32_t Interner::find(const std::string &name) const {
+    uint64_t hash = hash_string(name);
+    for (size_t i = hash & (slots.size() - 1); slots[i] != 0; i = (i + 1) & (slots.size() - 1)) {
+        uint32_t id = slots[i] - 1;
+        if (hashes[id] == hash && names[id] == name) {
+            return id;
+        }
+    }
+    return NO_NAME;
+}
+
+uint32_t Interner::intern(const std::string &name) {
+    uint32_t id = find(name);
+    if (id != NO_NAME) {
+        return id;
+    }
+    if ((names.size() + 1) * 4 > slots.size() * 3) {
+        grow();
+    }
+    id = (uint32_t) names.size();
+    names.push_back(name);
+    hashes.push_back(hash_string(name));
+    size_t i = hashes[id] & (slots.size() - 1);
+    while (slots[i] != 0) {
+        i = (i + 1) & (slots.size() - 1);
+    }
+    slots[i] = id + 1;
+    return id;
+}
+
+int SymbolTable::add_function(const std::string &name, const SymbolTableEntry &entry) {
+    int handle = (int) entries.size();
+    entries.push_back(entry);
+    entries.back().set_locals((int) locals.size());
+    locals.emplace_back();
+    function_list.push_back(handle);
+    int &binding = functions.slot(names.intern(name));
+    if (binding < 0) {
+        binding = handle;
+    }
+    return handle;
+}
+
+void SymbolTable::pop_scope() {
+    size_t mark = scopes.back();
+    scopes.pop_back();
+    while (undo.size() > mark) {
+        bindings.slot(undo.back().name) = undo.back().previous;
+        undo.pop_back();
+    }
+}
+
+int SymbolTable::declare(const std::string &name, const SymbolTableEntry &entry) {
+    uint32_t id = names.intern(name);
+    int &binding = bindings.slot(id);
+    int handle = (int) entries.size();
+    entries.push_back(entry);
+    undo.push_back({id, binding});
+    binding = handle;
+    return handle;
+}
@@ -0,0 +1,264 @@
+#ifndef SYMBOL_TABLE_H
+#define SYMBOL_TABLE_H
+
+#include <utility>
+
+#include "../utils.h"
+
+#define SYMBOL_MAP_MIN_CAPACITY 16
+#define NO_NAME 0xFFFFFFFFU
+
+enum id_type {
+    VAR,
+    FUNC,
+    NONE
+};
+
+class SymbolTableEntry {
+private:
+    std::string name;
+    id_type type;
+    type_id stype;  // the variable's type, or the function's return type
+    std::vector<std::pair<std::string, type_id>> parameters;
+    int def_area;
+    int locals;
+    bool mut;
+    ConstValue constant;  // known only for immutable bindings
+
+public:
+    SymbolTableEntry() {
+        type = NONE;
+        locals = -1;
+    }
+
+    SymbolTableEntry(id_type _type) {
+        type = _type;
+        stype = UNK;
+        def_area = 0;
+        locals = -1;
+        mut = false;
+    }
+
+    SymbolTableEntry(id_type _type, type_id _stype, int _def_area, bool _mut = false) {
+        type = _type;
+        stype = _stype;
+        def_area = _def_area;
+        locals = -1;
+        mut = _mut;
+    }
+
+
+    void set_name(std::string _name) {
+        name = std::move(_name);
+    }
+
+    std::string get_name() const {
+        return name;
+    }
+
+    void set_type(id_type _type) {
+        type = _type;
+    }
+
+    id_type get_type() const {
+        return type;
+    }
+
+    void set_stype(type_id _stype) {
+        stype = _stype;
+    }
+
+    void add_to_parameters(std::pair<std::string, type_id> parameter) {
+        parameters.push_back(parameter);
+    }
+
+    std::vector<std::pair<std::string, type_id>> &get_parameters() {
+        return parameters;
+    }
+
+    void set_constant(ConstValue _constant) {
+        constant = std::move(_constant);
+    }
+
+    const ConstValue &get_constant() const {
+        return constant;
+    }
+
+    void set_def_area(int _def_area) {
+        def_area = _def_area;
+    }
+
+    int get_def_area() const {
+        return def_area;
+    }
+
+    void set_locals(int _locals) {
+        locals = _locals;
+    }
+
+    int get_locals() const {
+        return locals;
+    }
+
+    void set_mut(bool _mut) {
+        mut = _mut;
+    }
+
+    bool get_mut() const {
+        return mut;
+    }
+
+    void clear_parameters() {
+        parameters.clear();
+    }
+
+    type_id get_stype() const {
+        return stype;
+    }
+
+    const std::vector<std::pair<std::string, type_id>>& get_parameters() const {
+        return parameters;
+    }
+};
+
+/*
+    Open-addressing map from interned name ids to entry handles, with linear probing and
+    a power-of-two capacity. Keys are never removed: unbinding a name stores -1, so probe
+    chains stay intact without tombstones.
+*/
+class IdMap {
+private:
+    std::vector<uint32_t> keys;
+    std::vector<int> values;
+    size_t count;
+
+    size_t home(uint32_t key) const {
+        return (key * 2654435761U) & (keys.size() - 1);
+    }
+
+    void grow();
+
+public:
+    IdMap() : keys(SYMBOL_MAP_MIN_CAPACITY, NO_NAME), values(SYMBOL_MAP_MIN_CAPACITY, -1), count(0) {}
+
+    int find(uint32_t key) const {
+        for (size_t i = home(key);; i = (i + 1) & (keys.size() - 1)) {
+            if (keys[i] == key) {
+                return values[i];
+            }
+            if (keys[i] == NO_NAME) {
+                return -1;
+            }
+        }
+    }
+
+    // the value stored for key, -1 if the key is new
+    int &slot(uint32_t key);
+};
+
+/*
+    Gives every distinct name a dense id, so scopes hash small integers instead of strings.
+    Looking a name up hashes it once and allocates nothing.
+*/
+class Interner {
+private:
+    std::vector<std::string> names;
+    std::vector<uint64_t> hashes;
+    std::vector<uint32_t> slots; // name id + 1, 0 if free
+
+    void grow();
+
+public:
+    Interner() : slots(SYMBOL_MAP_MIN_CAPACITY, 0) {}
+
+    // NO_NAME if the name was never interned
+    uint32_t find(const std::string &name) const;
+
+    uint32_t intern(const std::string &name);
+
+    const std::string &get_name(uint32_t id) const {
+        return names[id];
+    }
+};
+
+/*
+    Symbol table of the semantic analyzer. Entries live in a deque and are addressed by
+    handle, so a handle kept in the AST stays valid after its scope is gone.
+
+    Functions are global and never leave scope. Variables are bound in a stack of scopes:
+    declaring a name records the binding it hides in an undo log, and popping a scope
+    replays the log back to the scope's mark, so inner declarations shadow outer ones and
+    disappear at the end of their block.
+*/
+class SymbolTable {
+private:
+    struct Shadow {
+        uint32_t name;
+        int previous;
+    };
+
+    Interner names;
+    std::deque<SymbolTableEntry> entries;
+    IdMap functions;
+    IdMap bindings;
+    std::vector<int> function_list;
+    std::deque<SymbolTable> locals;  // a table stays put while a specialization is added
+    std::vector<Shadow> undo;
+    std::vector<size_t> scopes;
+
+public:
+    // every declaration gets its own entry and scope table, the name stays with the first one
+    int add_function(const std::string &name, const SymbolTableEntry &entry);
+
+    int find_function(const std::string &name) const {
+        uint32_t id = names.find(name);
+        return id == NO_NAME ? -1 : functions.find(id);
+    }
+
+    void push_scope() {
+        scopes.push_back(undo.size());
+    }
+
+    void pop_scope();
+
+    // number of open scopes, the def_area of the entries declared now
+    int depth() const {
+        return (int) scopes.size();
+    }
+
+    int declare(const std::string &name, const SymbolTableEntry &entry);
+
+    // innermost visible variable, -1 if none
+    int find(const std::string &name) const {
+        uint32_t id = names.find(name);
+        return id == NO_NAME ? -1 : bindings.find(id);
+    }
+
+    SymbolTableEntry &operator[](int handle) {
+        return entries[handle];
+    }
+
+    const SymbolTableEntry &operator[](int handle) const {
+        return entries[handle];
+    }
+
+    const std::deque<SymbolTableEntry> &get_entries() const {
+        return entries;
+    }
+
+    // the table a function's parameters and variables are declared in
+    SymbolTable &get_locals(int func) {
+        return locals[entries[func].get_locals()];
+    }
+
+    const SymbolTable &get_locals(int func) const {
+        return locals[entries[func].get_locals()];
+    }
+
+    // function handles in declaration order
+    const std::vector<int> &get_functions() const {
+        return function_list;
+    }
+};
+
+#endif // SYMBOL_TABLE_H
@@ -0,0 +1,97 @@
+#include "type_table.h"
+
+const TypeInfo TypeTable::primitives[UNK + 1] = {{VOID, UNK, 0, {}}, {INT, UNK, 0, {}}, {BOOL, UNK, 0, {}},
+                                                  {ARRAY, UNK, 0, {}}, {TUPLE, UNK, 0, {}}, {UNK, UNK, 0, {}}};
+
+TypeTable::TypeTable() : count(0), slots(TYPE_TABLE_MIN_CAPACITY, 0) {
+    for (auto &chunk: chunks) {
+        chunk.store(nullptr, std::memory_order_relaxed);
+    }
+    // stored like the others so interning finds them, read from primitives
+    for (const auto &primitive: primitives) {
+        intern(primitive);
+    }
+}
+
+TypeTable::~TypeTable() {
+    for (auto &chunk: chunks) {
+        delete[] chunk.load(std::memory_order_relaxed);
+    }
+}
+
+uint64_t TypeTable::hash(const TypeInfo &info) {
+    uint64_t hash = 14695981039346656037ULL;
+    auto mix = [&hash](uint32_t word) {
+        hash ^= word;
+        hash *= 1099511628211ULL;
+    };
+    mix(info.kind);
+    mix(info.element);
+    mix((uint32_t) info.length);
+    for (type_id element: info.elements) {
+        mix(element);
+    }
+    return hash;
+}
+
+void TypeTable::grow() {
+    slots.assign(slots.size() * 2, 0);
+    for (type_id id = 0; id < count.load(std::memory_order_relaxed); id++) {
+        size_t i = hashes[id] & (slots.size() - 1);
+        while (slots[i] != 0) {
+            i = (i + 1) & (slots.size() - 1);
+        }
+        slots[i] = id + 1;
+    }
+}
+
+type_id TypeTable::intern(const TypeInfo &info) {
+    std::lock_guard<std::mutex> guard(lock);
+    uint64_t info_hash = hash(info);
+    size_t i = info_hash & (slots.size() - 1);
+    for (; slots[i] != 0; i = (i + 1) & (slots.size() - 1)) {
+        type_id id = slots[i] - 1;
+        if (hashes[id] == info_hash && at(id) == info) {
+            return id;
+        }
+    }
+
+    // the new type is written before the count is published, readers never see it half-built
+    type_id id = count.load(std::memory_order_relaxed);
+    int chunk = chunk_of(id);
+    if (chunks[chunk].load(std::memory_order_relaxed) == nullptr) {
+        chunks[chunk].store(new TypeInfo[(size_t) TYPE_TABLE_FIRST_CHUNK << chunk], std::memory_order_release);
+    }
+    at(id) = info;
+    hashes.push_back(info_hash);
+    count.store(id + 1, std::memory_order_release);
+    if ((id + 2) * 4 > slots.size() * 3) {
+        grow();
+    } else {
+        slots[i] = id + 1;
+    }
+    return id;
+}
+
+type_id TypeTable::array(type_id element, int length) {
+    return intern({ARRAY, element, length, {}});
+}
+
+type_id TypeTable::tuple(const std::vector<type_id> &elements) {
+    return intern({TUPLE, UNK, 0, elements});
+}
+
+std::string TypeTable::to_string(type_id id) const {
+    const TypeInfo &info = (*this)[id];
+    if (info.kind == ARRAY && id != ARRAY) {
+        return "[" + to_string(info.element) + "; " + std::to_string(info.length) + "]";
+    }
+    if (info.kind == TUPLE && id != TUPLE) {
+        std::string text = "(";
+        for (size_t i = 0; i < info.elements.size(); i++) {
+            text += (i ? ", " : "") + to_string(info.elements[i]);
+        }
+        return text + ")";
+    }
+    return semantic_type_to_string[info.kind];
+}
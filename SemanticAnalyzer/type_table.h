@@ -0,0 +1,91 @@
+#ifndef TYPE_TABLE_H
+#define TYPE_TABLE_H
+
+#include <atomic>
+#include <mutex>
+
+#include "../utils.h"
+
+#define TYPE_TABLE_MIN_CAPACITY 64
+#define TYPE_TABLE_FIRST_CHUNK 64
+#define TYPE_TABLE_MAX_CHUNKS 26
+
+struct TypeInfo {
+    semantic_type kind;
+    type_id element;                // array element type
+    int length;                     // array length, 0 if unknown
+    std::vector<type_id> elements;  // tuple element types
+
+    bool operator==(const TypeInfo &other) const {
+        return kind == other.kind && element == other.element && length == other.length &&
+               elements == other.elements;
+    }
+};
+
+/*
+    Hash-consed types: every distinct type is stored once and named by its index, so two types
+    are equal exactly when their ids are, and an entry or node keeps one id instead of copies
+    of its element types.
+
+    The types without structure are entered first, in semantic_type order, so INT, BOOL, VOID
+    and UNK are their own ids; ARRAY and TUPLE name an array or a tuple whose structure isn't
+    known. Function bodies are checked on several threads, so entering a type takes a lock.
+    An entered type never moves or changes, so reading one doesn't: types are kept in chunks
+    of doubling size that are never reallocated, and the primitives aren't looked up at all.
+*/
+class TypeTable {
+private:
+    static const TypeInfo primitives[UNK + 1];
+
+    std::atomic<TypeInfo *> chunks[TYPE_TABLE_MAX_CHUNKS];
+    std::atomic<type_id> count;  // published after the type is in its chunk
+    std::vector<uint64_t> hashes;
+    std::vector<uint32_t> slots; // type id + 1, 0 if free
+    std::mutex lock;
+
+    // chunk k holds TYPE_TABLE_FIRST_CHUNK << k types
+    static int chunk_of(type_id id) {
+        return (int) std::bit_width(id / TYPE_TABLE_FIRST_CHUNK + 1) - 1;
+    }
+
+    TypeInfo &at(type_id id) const {
+        int chunk = chunk_of(id);
+        return chunks[chunk].load(std::memory_order_acquire)[id - TYPE_TABLE_FIRST_CHUNK * ((1U << chunk) - 1)];
+    }
+
+    static uint64_t hash(const TypeInfo &info);
+
+    void grow();
+
+    type_id intern(const TypeInfo &info);
+
+public:
+    TypeTable();
+
+    ~TypeTable();
+
+    TypeTable(const TypeTable &) = delete;
+
+    TypeTable &operator=(const TypeTable &) = delete;
+
+    type_id array(type_id element, int length);
+
+    type_id tuple(const std::vector<type_id> &elements);
+
+    const TypeInfo &operator[](type_id id) const {
+        return id <= UNK ? primitives[id] : at(id);
+    }
+
+    semantic_type kind(type_id id) const {
+        return id <= UNK ? (semantic_type) id : at(id).kind;
+    }
+
+    type_id size() const {
+        return count.load(std::memory_order_acquire);
+    }
+
+    // int, bool, [int; 3], (int, [bool; 2])
+    std::string to_string(type_id id) const;
+};
+
+#endif // TYPE_TABLE_H
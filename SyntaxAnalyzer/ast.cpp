@@ -0,0 +1,256 @@
+#include "ast.h"
+
+void get_ast_children(AstNode *node, std::vector<AstNode *> &children) {
+    auto add = [&children](AstNode *child) {
+        if (child != nullptr) {
+            children.push_back(child);
+        }
+    };
+
+    switch (node->kind) {
+        case AST_PROGRAM:
+            for (auto item: static_cast<Program *>(node)->items) add(item);
+            break;
+        case AST_FUNC_DECL: {
+            auto *func = static_cast<FuncDecl *>(node);
+            for (auto param: func->params) add(param);
+            add(func->ret_type);
+            add(func->body);
+            add(func->ret);
+            break;
+        }
+        case AST_PARAM:
+            add(static_cast<Param *>(node)->type);
+            break;
+        case AST_TYPE: {
+            auto *type = static_cast<TypeExpr *>(node);
+            for (auto element: type->elements) add(element);
+            add(type->element);
+            break;
+        }
+        case AST_BLOCK:
+            for (auto stmt: static_cast<Block *>(node)->stmts) add(stmt);
+            break;
+        case AST_LET:
+            add(static_cast<Let *>(node)->type);
+            add(static_cast<Let *>(node)->init);
+            break;
+        case AST_ASSIGN:
+            add(static_cast<Assign *>(node)->value);
+            break;
+        case AST_INDEX_ASSIGN:
+            add(static_cast<IndexAssign *>(node)->index);
+            add(static_cast<IndexAssign *>(node)->value);
+            break;
+        case AST_CALL_STMT:
+            add(static_cast<CallStmt *>(node)->call);
+            break;
+        case AST_IF:
+            add(static_cast<If *>(node)->cond);
+            add(static_cast<If *>(node)->then_block);
+            add(static_cast<If *>(node)->else_branch);
+            break;
+        case AST_LOOP:
+            add(static_cast<Loop *>(node)->body);
+            break;
+        case AST_PRINTLN:
+            for (auto arg: static_cast<Println *>(node)->args) add(arg);
+            break;
+        case AST_BINARY:
+            add(static_cast<Binary *>(node)->lhs);
+            add(static_cast<Binary *>(node)->rhs);
+            break;
+        case AST_UNARY:
+            add(static_cast<Unary *>(node)->operand);
+            break;
+        case AST_CALL:
+            for (auto arg: static_cast<Call *>(node)->args) add(arg);
+            break;
+        case AST_INDEX:
+            add(static_cast<Index *>(node)->index);
+            break;
+        case AST_TUPLE_LIT:
+            for (auto element: static_cast<TupleLit *>(node)->elements) add(element);
+            break;
+        case AST_ARRAY_LIT:
+            for (auto element: static_cast<ArrayLit *>(node)->elements) add(element);
+            break;
+        case AST_NAMED_ARG:
+            add(static_cast<NamedArg *>(node)->target);
+            add(static_cast<NamedArg *>(node)->value);
+            break;
+        default:
+            break;
+    }
+}
+
+std::string ast_to_string(AstNode *node) {
+    std::string res = ast_kind_to_string[node->kind];
+    switch (node->kind) {
+        case AST_FUNC_DECL:
+            return res + " " + static_cast<FuncDecl *>(node)->name;
+        case AST_PARAM:
+            return res + " " + static_cast<Param *>(node)->name;
+        case AST_TYPE: {
+            auto *type = static_cast<TypeExpr *>(node);
+            res += " " + semantic_type_to_string[type->stype];
+            if (type->stype == ARRAY) {
+                res += "; " + std::to_string(type->length);
+            }
+            return res;
+        }
+        case AST_LET: {
+            auto *let = static_cast<Let *>(node);
+            res += let->mut ? " mut " : " ";
+            if (!let->tuple_pattern) {
+                return res + let->names[0];
+            }
+            res += "(";
+            for (size_t i = 0; i < let->names.size(); i++) {
+                res += (i ? ", " : "") + let->names[i];
+            }
+            return res + ")";
+        }
+        case AST_ASSIGN:
+            return res + " " + static_cast<Assign *>(node)->name;
+        case AST_INDEX_ASSIGN:
+            return res + " " + static_cast<IndexAssign *>(node)->name;
+        case AST_PRINTLN:
+            if (static_cast<Println *>(node)->has_format) {
+                return res + " \"" + static_cast<Println *>(node)->format + "\"";
+            }
+            return res;
+        case AST_BINARY:
+            return res + " " + ast_op_to_string[static_cast<Binary *>(node)->op];
+        case AST_UNARY:
+            return res + " " + ast_op_to_string[static_cast<Unary *>(node)->op];
+        case AST_LITERAL:
+            return res + " " + static_cast<Literal *>(node)->text;
+        case AST_NAME:
+            return res + " " + static_cast<Name *>(node)->name;
+        case AST_CALL:
+            return res + " " + static_cast<Call *>(node)->name;
+        case AST_INDEX:
+            return res + " " + static_cast<Index *>(node)->name;
+        default:
+            return res;
+    }
+}
+
+template<typename T>
+static std::vector<T *> clone_list(const std::vector<T *> &nodes, Arena &arena) {
+    std::vector<T *> copies;
+    for (auto node: nodes) {
+        copies.push_back(static_cast<T *>(clone_ast(node, arena)));
+    }
+    return copies;
+}
+
+AstNode *clone_ast(AstNode *node, Arena &arena) {
+    if (node == nullptr) {
+        return nullptr;
+    }
+
+    switch (node->kind) {
+        case AST_FUNC_DECL: {
+            auto *func = static_cast<FuncDecl *>(node);
+            auto *copy = arena.make<FuncDecl>(func->line, func->name);
+            copy->params = clone_list(func->params, arena);
+            copy->ret_type = func->ret_type;
+            copy->body = static_cast<Block *>(clone_ast(func->body, arena));
+            copy->ret = static_cast<Expr *>(clone_ast(func->ret, arena));
+            return copy;
+        }
+        case AST_PARAM: {
+            auto *param = static_cast<Param *>(node);
+            return arena.make<Param>(param->line, param->name, param->type);
+        }
+        case AST_BLOCK: {
+            auto *copy = arena.make<Block>(node->line);
+            copy->stmts = clone_list(static_cast<Block *>(node)->stmts, arena);
+            return copy;
+        }
+        case AST_LET: {
+            auto *let = static_cast<Let *>(node);
+            auto *copy = arena.make<Let>(let->line);
+            copy->mut = let->mut;
+            copy->tuple_pattern = let->tuple_pattern;
+            copy->names = let->names;
+            copy->type = let->type;
+            copy->init = static_cast<Expr *>(clone_ast(let->init, arena));
+            return copy;
+        }
+        case AST_ASSIGN: {
+            auto *assign = static_cast<Assign *>(node);
+            return arena.make<Assign>(assign->line, assign->name, static_cast<Expr *>(clone_ast(assign->value, arena)));
+        }
+        case AST_INDEX_ASSIGN: {
+            auto *assign = static_cast<IndexAssign *>(node);
+            return arena.make<IndexAssign>(assign->line, assign->name,
+                                           static_cast<Expr *>(clone_ast(assign->index, arena)),
+                                           static_cast<Expr *>(clone_ast(assign->value, arena)));
+        }
+        case AST_CALL_STMT:
+            return arena.make<CallStmt>(node->line,
+                                        static_cast<Call *>(clone_ast(static_cast<CallStmt *>(node)->call, arena)));
+        case AST_IF: {
+            auto *if_stmt = static_cast<If *>(node);
+            return arena.make<If>(if_stmt->line, static_cast<Expr *>(clone_ast(if_stmt->cond, arena)),
+                                  static_cast<Block *>(clone_ast(if_stmt->then_block, arena)),
+                                  clone_ast(if_stmt->else_branch, arena));
+        }
+        case AST_LOOP:
+            return arena.make<Loop>(node->line, static_cast<Block *>(clone_ast(static_cast<Loop *>(node)->body, arena)));
+        case AST_PRINTLN: {
+            auto *println = static_cast<Println *>(node);
+            auto *copy = arena.make<Println>(println->line);
+            copy->has_format = println->has_format;
+            copy->format = println->format;
+            copy->args = clone_list(println->args, arena);
+            return copy;
+        }
+        case AST_BINARY: {
+            auto *binary = static_cast<Binary *>(node);
+            return arena.make<Binary>(binary->line, binary->op, static_cast<Expr *>(clone_ast(binary->lhs, arena)),
+                                      static_cast<Expr *>(clone_ast(binary->rhs, arena)));
+        }
+        case AST_UNARY: {
+            auto *unary = static_cast<Unary *>(node);
+            return arena.make<Unary>(unary->line, unary->op, static_cast<Expr *>(clone_ast(unary->operand, arena)));
+        }
+        case AST_LITERAL: {
+            auto *literal = static_cast<Literal *>(node);
+            return arena.make<Literal>(literal->line, literal->token, literal->text);
+        }
+        case AST_NAME:
+            return arena.make<Name>(node->line, static_cast<Name *>(node)->name);
+        case AST_CALL: {
+            auto *call = static_cast<Call *>(node);
+            auto *copy = arena.make<Call>(call->line, call->name);
+            copy->args = clone_list(call->args, arena);
+            return copy;
+        }
+        case AST_INDEX: {
+            auto *index = static_cast<Index *>(node);
+            return arena.make<Index>(index->line, index->name, static_cast<Expr *>(clone_ast(index->index, arena)));
+        }
+        case AST_TUPLE_LIT: {
+            auto *copy = arena.make<TupleLit>(node->line);
+            copy->elements = clone_list(static_cast<TupleLit *>(node)->elements, arena);
+            return copy;
+        }
+        case AST_ARRAY_LIT: {
+            auto *copy = arena.make<ArrayLit>(node->line);
+            copy->elements = clone_list(static_cast<ArrayLit *>(node)->elements, arena);
+            return copy;
+        }
+        case AST_NAMED_ARG: {
+            auto *named_arg = static_cast<NamedArg *>(node);
+            return arena.make<NamedArg>(named_arg->line, static_cast<Expr *>(clone_ast(named_arg->target, arena)),
+                                        static_cast<Expr *>(clone_ast(named_arg->value, arena)));
+        }
+        default:
+            // types are never annotated, a copy shares them
+            return node;
+    }
+}
@@ -0,0 +1,280 @@
+#ifndef AST_H
+#define AST_H
+
+#include "../utils.h"
+
+enum ast_kind {
+    AST_PROGRAM,
+    AST_FUNC_DECL,
+    AST_PARAM,
+    AST_TYPE,
+    AST_BLOCK,
+    AST_LET,
+    AST_ASSIGN,
+    AST_INDEX_ASSIGN,
+    AST_CALL_STMT,
+    AST_IF,
+    AST_LOOP,
+    AST_BREAK,
+    AST_CONTINUE,
+    AST_PRINTLN,
+    AST_BINARY,
+    AST_UNARY,
+    AST_LITERAL,
+    AST_NAME,
+    AST_CALL,
+    AST_INDEX,
+    AST_TUPLE_LIT,
+    AST_ARRAY_LIT,
+    AST_NAMED_ARG
+};
+
+const std::string ast_kind_to_string[] = {
+        "Program",
+        "FuncDecl",
+        "Param",
+        "Type",
+        "Block",
+        "Let",
+        "Assign",
+        "IndexAssign",
+        "CallStmt",
+        "If",
+        "Loop",
+        "Break",
+        "Continue",
+        "Println",
+        "Binary",
+        "Unary",
+        "Literal",
+        "Name",
+        "Call",
+        "Index",
+        "TupleLit",
+        "ArrayLit",
+        "NamedArg"
+};
+
+enum ast_op {
+    OP_OR,
+    OP_AND,
+    OP_EQ,
+    OP_NE,
+    OP_LT,
+    OP_LE,
+    OP_GT,
+    OP_GE,
+    OP_ADD,
+    OP_SUB,
+    OP_MUL,
+    OP_DIV,
+    OP_REM,
+    OP_NOT,
+    OP_NEG
+};
+
+// Trust and C spell every operator the same way
+const std::string ast_op_to_string[] = {"||", "&&", "==", "!=", "<", "<=", ">", ">=", "+", "-", "*", "/", "%", "!", "-"};
+
+const int ast_op_precedence[] = {1, 2, 3, 3, 4, 4, 4, 4, 5, 5, 6, 6, 6, 7, 7};
+
+/*
+    Typed AST lowered from the LL(1) parse tree. There are no eps leaves or *_tail chains:
+    lists are vectors, operators are resolved to ast_op and every binary operator is one
+    left-associative node. Nodes are allocated from the SyntaxAnalyzer's arena and never
+    freed one by one. Expressions carry the annotations filled in by semantic analysis.
+*/
+struct AstNode {
+    ast_kind kind;
+    int line;
+
+    AstNode(ast_kind _kind, int _line) : kind(_kind), line(_line) {}
+};
+
+struct Expr : AstNode {
+    exp_type exp_t;
+    type_id type;
+    ConstValue constant;
+
+    Expr(ast_kind _kind, int _line) : AstNode(_kind, _line), exp_t(TYPE_UNKNOWN), type(UNK) {}
+};
+
+struct TypeExpr : AstNode {
+    semantic_type stype;
+    std::vector<TypeExpr *> elements; // tuple element types
+    TypeExpr *element;                // array element type, nullptr for `[; n]`
+    int length;                       // array length, 0 if omitted
+
+    TypeExpr(int _line, semantic_type _stype) : AstNode(AST_TYPE, _line), stype(_stype), element(nullptr), length(0) {}
+};
+
+struct Block : AstNode {
+    std::vector<AstNode *> stmts;
+
+    explicit Block(int _line) : AstNode(AST_BLOCK, _line) {}
+};
+
+struct Param : AstNode {
+    std::string name;
+    TypeExpr *type;
+    int symbol; // symbol table handle, set by the semantic analyzer
+
+    Param(int _line, std::string _name, TypeExpr *_type) : AstNode(AST_PARAM, _line), name(std::move(_name)),
+                                                           type(_type), symbol(-1) {}
+};
+
+struct FuncDecl : AstNode {
+    std::string name;
+    std::vector<Param *> params;
+    TypeExpr *ret_type;
+    Block *body;
+    Expr *ret;
+    int symbol;
+
+    FuncDecl(int _line, std::string _name) : AstNode(AST_FUNC_DECL, _line), name(std::move(_name)), ret_type(nullptr),
+                                             body(nullptr), ret(nullptr), symbol(-1) {}
+};
+
+struct Program : AstNode {
+    std::vector<AstNode *> items; // functions, or top-level statements
+
+    Program() : AstNode(AST_PROGRAM, 0) {}
+};
+
+struct Let : AstNode {
+    bool mut;
+    bool tuple_pattern;
+    std::vector<std::string> names;
+    std::vector<int> symbols; // one handle per name, a redeclaration in the same scope reuses the earlier one
+    TypeExpr *type;
+    Expr *init;
+
+    explicit Let(int _line) : AstNode(AST_LET, _line), mut(false), tuple_pattern(false), type(nullptr),
+                              init(nullptr) {}
+};
+
+struct Assign : AstNode {
+    std::string name;
+    Expr *value;
+
+    Assign(int _line, std::string _name, Expr *_value) : AstNode(AST_ASSIGN, _line), name(std::move(_name)),
+                                                         value(_value) {}
+};
+
+struct IndexAssign : AstNode {
+    std::string name;
+    Expr *index;
+    Expr *value;
+
+    IndexAssign(int _line, std::string _name, Expr *_index, Expr *_value) : AstNode(AST_INDEX_ASSIGN, _line),
+                                                                           name(std::move(_name)), index(_index),
+                                                                           value(_value) {}
+};
+
+struct Call;
+
+struct CallStmt : AstNode {
+    Call *call;
+
+    CallStmt(int _line, Call *_call) : AstNode(AST_CALL_STMT, _line), call(_call) {}
+};
+
+struct If : AstNode {
+    Expr *cond;
+    Block *then_block;
+    AstNode *else_branch; // Block, If for `else if`, or nullptr
+
+    If(int _line, Expr *_cond, Block *_then_block, AstNode *_else_branch) : AstNode(AST_IF, _line), cond(_cond),
+                                                                           then_block(_then_block),
+                                                                           else_branch(_else_branch) {}
+};
+
+struct Loop : AstNode {
+    Block *body;
+
+    Loop(int _line, Block *_body) : AstNode(AST_LOOP, _line), body(_body) {}
+};
+
+struct Println : AstNode {
+    bool has_format;
+    std::string format;
+    std::vector<Expr *> args;
+
+    explicit Println(int _line) : AstNode(AST_PRINTLN, _line), has_format(false) {}
+};
+
+struct Binary : Expr {
+    ast_op op;
+    Expr *lhs;
+    Expr *rhs;
+
+    Binary(int _line, ast_op _op, Expr *_lhs, Expr *_rhs) : Expr(AST_BINARY, _line), op(_op), lhs(_lhs), rhs(_rhs) {}
+};
+
+struct Unary : Expr {
+    ast_op op;
+    Expr *operand;
+
+    Unary(int _line, ast_op _op, Expr *_operand) : Expr(AST_UNARY, _line), op(_op), operand(_operand) {}
+};
+
+struct Literal : Expr {
+    token_type token; // T_Decimal, T_Hexadecimal, T_String, T_True or T_False
+    std::string text;
+
+    Literal(int _line, token_type _token, std::string _text) : Expr(AST_LITERAL, _line), token(_token),
+                                                              text(std::move(_text)) {}
+};
+
+struct Name : Expr {
+    std::string name;
+    int symbol; // the variable it resolved to, -1 for a function or an undeclared name
+
+    Name(int _line, std::string _name) : Expr(AST_NAME, _line), name(std::move(_name)), symbol(-1) {}
+};
+
+struct Call : Expr {
+    std::string name;
+    std::vector<Expr *> args;
+    int symbol; // the function or specialization called, set by the semantic analyzer
+
+    Call(int _line, std::string _name) : Expr(AST_CALL, _line), name(std::move(_name)), symbol(-1) {}
+};
+
+struct Index : Expr {
+    std::string name;
+    Expr *index;
+
+    Index(int _line, std::string _name, Expr *_index) : Expr(AST_INDEX, _line), name(std::move(_name)),
+                                                        index(_index) {}
+};
+
+struct TupleLit : Expr {
+    std::vector<Expr *> elements;
+
+    explicit TupleLit(int _line) : Expr(AST_TUPLE_LIT, _line) {}
+};
+
+struct ArrayLit : Expr {
+    std::vector<Expr *> elements;
+
+    explicit ArrayLit(int _line) : Expr(AST_ARRAY_LIT, _line) {}
+};
+
+// `target = value` inside an argument list, e.g. println!("{x}", x = 5)
+struct NamedArg : Expr {
+    Expr *target;
+    Expr *value;
+
+    NamedArg(int _line, Expr *_target, Expr *_value) : Expr(AST_NAMED_ARG, _line), target(_target), value(_value) {}
+};
+
+// appends the non-null children of node in source order
+void get_ast_children(AstNode *node, std::vector<AstNode *> &children);
+
+std::string ast_to_string(AstNode *node);
+
+// a deep copy of a function or statement without the annotations of semantic analysis
+AstNode *clone_ast(AstNode *node, Arena &arena);
+
+#endif // AST_H
@@ -0,0 +1,479 @@
+#include "ast_builder.h"
+
+AstBuilder::AstBuilder(Arena &_arena) {
+    arena = &_arena;
+}
+
+static grammar_symbol symbol_kind(const std::string &name) {
+    static const std::map<std::string, grammar_symbol> symbols = [] {
+        std::map<std::string, grammar_symbol> res;
+        for (int symbol = SYM_NONE + 1; symbol < NUM_GRAMMAR_SYMBOLS; symbol++) {
+            res[grammar_symbol_names[symbol]] = (grammar_symbol) symbol;
+        }
+        return res;
+    }();
+    auto it = symbols.find(name);
+    return it == symbols.end() ? SYM_NONE : it->second;
+}
+
+TreeNode AstBuilder::child(TreeNode node, int index) {
+    return node.get_children()[index];
+}
+
+// true for a missing node, a node error recovery never expanded, or an eps production
+bool AstBuilder::is_empty(TreeNode node) const {
+    return !node || node.get_children().empty() || kind(node.get_children()[0]) == SYM_eps;
+}
+
+// <list> -> <item> <list_tail>; the spliced tail holds separators and items, then eps
+std::vector<TreeNode> AstBuilder::get_items(TreeNode list, grammar_symbol item) const {
+    std::vector<TreeNode> items;
+    TreeNode first = child(list, 0);
+    if (first && kind(first) == item) {
+        items.push_back(first);
+    }
+    TreeNode tail = child(list, 1);
+    if (tail) {
+        for (TreeNode part: tail.get_children()) {
+            if (kind(part) == item) {
+                items.push_back(part);
+            }
+        }
+    }
+    return items;
+}
+
+int AstBuilder::get_line(TreeNode node) {
+    return node ? node.get_line_number() : -1;
+}
+
+ast_op AstBuilder::get_op(grammar_symbol symbol) {
+    switch (symbol) {
+        case SYM_T_LOp_OR:
+            return OP_OR;
+        case SYM_T_LOp_AND:
+            return OP_AND;
+        case SYM_T_ROp_E:
+            return OP_EQ;
+        case SYM_T_ROp_NE:
+            return OP_NE;
+        case SYM_T_ROp_L:
+            return OP_LT;
+        case SYM_T_ROp_LE:
+            return OP_LE;
+        case SYM_T_ROp_G:
+            return OP_GT;
+        case SYM_T_ROp_GE:
+            return OP_GE;
+        case SYM_T_AOp_Trust:
+            return OP_ADD;
+        case SYM_T_AOp_MN:
+            return OP_SUB;
+        case SYM_T_AOp_ML:
+            return OP_MUL;
+        case SYM_T_AOp_DV:
+            return OP_DIV;
+        default:
+            return OP_REM;
+    }
+}
+
+Program *AstBuilder::build(const ParseTree &tree) {
+    auto *program = arena->make<Program>();
+    kinds.clear();
+    for (int symbol = 0; symbol < tree.get_num_symbols(); symbol++) {
+        kinds.push_back(symbol_kind(tree.get_symbol_name(symbol)));
+    }
+
+    // <func_ls> -> <func> <func_ls> @ <stmt_ls>, spliced into <func> ... <func> <stmt_ls>
+    TreeNode func_ls = child(tree.get_root(), 0);
+    if (!func_ls) {
+        return program;
+    }
+    for (TreeNode item: func_ls.get_children()) {
+        switch (kind(item)) {
+            case SYM_func: {
+                FuncDecl *func = build_func(item);
+                if (func != nullptr) {
+                    program->items.push_back(func);
+                }
+                break;
+            }
+            case SYM_stmt_ls:
+                build_stmts(item, program->items);
+                break;
+            default:
+                break;
+        }
+    }
+    return program;
+}
+
+void AstBuilder::build_stmts(TreeNode stmt_ls, std::vector<AstNode *> &stmts) {
+    if (!stmt_ls) {
+        return;
+    }
+    for (TreeNode item: stmt_ls.get_children()) {
+        if (kind(item) != SYM_stmt) {
+            continue;
+        }
+        AstNode *stmt = build_stmt(item);
+        if (stmt != nullptr) {
+            stmts.push_back(stmt);
+        }
+    }
+}
+
+Block *AstBuilder::build_block(TreeNode stmt_ls, int line) {
+    auto *block = arena->make<Block>(line);
+    build_stmts(stmt_ls, block->stmts);
+    return block;
+}
+
+FuncDecl *AstBuilder::build_func(TreeNode node) {
+    // T_Fn T_Id T_LP <func_args> T_RP <func_type> T_LC <stmt_ls> <return_stmt> T_RC
+    if (is_empty(node)) {
+        return nullptr;
+    }
+    auto *func = arena->make<FuncDecl>(get_line(node), child(node, 1).get_content());
+
+    for (TreeNode arg: get_items(child(node, 3), SYM_arg)) {
+        if (!is_empty(arg)) {
+            TreeNode arg_type = child(arg, 1);
+            TypeExpr *type = is_empty(arg_type) ? nullptr : build_type(child(arg_type, 1));
+            func->params.push_back(arena->make<Param>(get_line(arg), child(arg, 0).get_content(), type));
+        }
+    }
+
+    TreeNode func_type = child(node, 5);
+    if (!is_empty(func_type)) {
+        func->ret_type = build_type(child(func_type, 1));
+    }
+    func->body = build_block(child(node, 7), get_line(child(node, 6)));
+
+    TreeNode return_stmt = child(node, 8);
+    if (!is_empty(return_stmt)) {
+        func->ret = build_exp(child(return_stmt, 1));
+    }
+    return func;
+}
+
+AstNode *AstBuilder::build_stmt(TreeNode node) {
+    TreeNode first = child(node, 0);
+    int line = get_line(first);
+
+    switch (kind(first)) {
+        case SYM_var_declaration:
+            return build_let(first);
+        case SYM_T_Id:
+            return build_id_stmt(node);
+        case SYM_if_stmt:
+            return build_if(first);
+        case SYM_println_stmt:
+            return build_println(first);
+        case SYM_loop_stmt:
+            // T_Loop T_LC <stmt_ls> T_RC
+            if (is_empty(first)) {
+                return nullptr;
+            }
+            return arena->make<Loop>(line, build_block(child(first, 2), get_line(child(first, 1))));
+        case SYM_break_stmt:
+            return arena->make<AstNode>(AST_BREAK, line);
+        case SYM_continue_stmt:
+            return arena->make<AstNode>(AST_CONTINUE, line);
+        default:
+            return nullptr;
+    }
+}
+
+Let *AstBuilder::build_let(TreeNode node) {
+    // T_Let <mut_opt> <pattern> <type_opt> <assign_opt>
+    if (is_empty(node)) {
+        return nullptr;
+    }
+    auto *let = arena->make<Let>(get_line(node));
+    let->mut = kind(child(child(node, 1), 0)) == SYM_T_Mut;
+
+    TreeNode pattern = child(node, 2);
+    if (kind(child(pattern, 0)) == SYM_T_LP) {
+        // T_LP <id_ls> T_RP, <id_ls> -> T_Id <id_ls_tail>
+        let->tuple_pattern = true;
+        for (TreeNode id: get_items(child(pattern, 1), SYM_T_Id)) {
+            let->names.push_back(id.get_content());
+        }
+    } else if (child(pattern, 0)) {
+        let->names.push_back(child(pattern, 0).get_content());
+    }
+    if (let->names.empty()) {
+        return nullptr;
+    }
+
+    TreeNode type_opt = child(node, 3);
+    if (!is_empty(type_opt)) {
+        let->type = build_type(child(type_opt, 1));
+    }
+    TreeNode assign_opt = child(node, 4);
+    if (!is_empty(assign_opt)) {
+        let->init = build_exp(child(assign_opt, 1));
+    }
+    return let;
+}
+
+AstNode *AstBuilder::build_id_stmt(TreeNode node) {
+    // T_Id <stmt_after_id> T_Semicolon
+    std::string name = child(node, 0).get_content();
+    int line = get_line(child(node, 0));
+    TreeNode after_id = child(node, 1);
+
+    switch (kind(child(after_id, 0))) {
+        case SYM_T_Assign: {
+            Expr *value = build_exp(child(after_id, 1));
+            return value ? arena->make<Assign>(line, name, value) : nullptr;
+        }
+        case SYM_T_LB: {
+            // T_LB <exp> T_RB T_Assign <exp>
+            Expr *index = build_exp(child(after_id, 1));
+            Expr *value = build_exp(child(after_id, 4));
+            return index && value ? arena->make<IndexAssign>(line, name, index, value) : nullptr;
+        }
+        case SYM_T_LP: {
+            auto *call = arena->make<Call>(line, name);
+            build_exp_ls(child(after_id, 1), call->args);
+            return arena->make<CallStmt>(line, call);
+        }
+        default:
+            return nullptr;
+    }
+}
+
+If *AstBuilder::build_if(TreeNode node) {
+    // T_If <exp> T_LC <stmt_ls> T_RC <else_part_opt>
+    if (is_empty(node)) {
+        return nullptr;
+    }
+    Expr *cond = build_exp(child(node, 1));
+    Block *then_block = build_block(child(node, 3), get_line(child(node, 2)));
+
+    AstNode *else_branch = nullptr;
+    TreeNode else_part = child(node, 5);
+    if (!is_empty(else_part)) {
+        // <else_alternative> -> <if_stmt> @ T_LC <stmt_ls> T_RC
+        TreeNode alternative = child(else_part, 1);
+        TreeNode first = child(alternative, 0);
+        if (kind(first) == SYM_if_stmt) {
+            else_branch = build_if(first);
+        } else if (kind(first) == SYM_T_LC) {
+            else_branch = build_block(child(alternative, 1), get_line(first));
+        }
+    }
+    return arena->make<If>(get_line(node), cond, then_block, else_branch);
+}
+
+Println *AstBuilder::build_println(TreeNode node) {
+    // T_Print T_LP <println_args> T_RP T_Semicolon
+    auto *println = arena->make<Println>(get_line(node));
+    TreeNode args = child(node, 2);
+    TreeNode first = child(args, 0);
+
+    if (kind(first) == SYM_T_String) {
+        println->has_format = true;
+        println->format = first.get_content();
+
+        // <println_format_args_opt> -> T_Comma <println_format_args_list> @ eps
+        TreeNode format_args = child(args, 1);
+        if (!is_empty(format_args)) {
+            for (TreeNode item: get_items(child(format_args, 1), SYM_println_format_arg_item)) {
+                Expr *arg = build_arg_item(child(item, 0));
+                if (arg != nullptr) {
+                    println->args.push_back(arg);
+                }
+            }
+        }
+    } else if (first) {
+        Expr *arg = build_exp(first);
+        if (arg != nullptr) {
+            println->args.push_back(arg);
+        }
+    }
+    return println;
+}
+
+TypeExpr *AstBuilder::build_type(TreeNode node) {
+    // <type> and <opt_type>; an eps <opt_type> gives nullptr
+    if (is_empty(node)) {
+        return nullptr;
+    }
+    TreeNode first = child(node, 0);
+    int line = get_line(first);
+
+    switch (kind(first)) {
+        case SYM_T_Int:
+            return arena->make<TypeExpr>(line, INT);
+        case SYM_T_Bool:
+            return arena->make<TypeExpr>(line, BOOL);
+        case SYM_T_LP: {
+            // T_LP <type_ls> T_RP, <type_ls> -> <type> <type_ls_tail> @ eps
+            auto *type = arena->make<TypeExpr>(line, TUPLE);
+            for (TreeNode item: get_items(child(node, 1), SYM_type)) {
+                TypeExpr *element = build_type(item);
+                if (element != nullptr) {
+                    type->elements.push_back(element);
+                }
+            }
+            return type;
+        }
+        case SYM_T_LB: {
+            // T_LB <opt_type> T_Semicolon <opt_dec> T_RB
+            auto *type = arena->make<TypeExpr>(line, ARRAY);
+            type->element = build_type(child(node, 1));
+            TreeNode opt_dec = child(node, 3);
+            if (!is_empty(opt_dec) && !child(opt_dec, 0).get_content().empty()) {
+                type->length = std::stoi(child(opt_dec, 0).get_content());
+            }
+            return type;
+        }
+        default:
+            return nullptr;
+    }
+}
+
+Expr *AstBuilder::build_exp(TreeNode node) {
+    if (!node) {
+        return nullptr;
+    }
+    grammar_symbol symbol = kind(node);
+
+    if (symbol == SYM_exp) {
+        // <exp> holds the operator tree built by the precedence parser
+        return is_empty(node) ? nullptr : build_exp(child(node, 0));
+    } else if (symbol == SYM_exp_operand) {
+        return is_empty(node) ? nullptr : build_factor(node);
+    }
+
+    // operators are their terminals: two children for a binary operator, one for a prefix operator
+    ChildRange operands = node.get_children();
+    if (operands.size() == 2) {
+        Expr *lhs = build_exp(operands[0]);
+        Expr *rhs = build_exp(operands[1]);
+        if (lhs == nullptr || rhs == nullptr) {
+            return lhs ? lhs : rhs;
+        }
+        return arena->make<Binary>(get_line(node), get_op(symbol), lhs, rhs);
+    } else if (operands.size() == 1) {
+        Expr *operand = build_exp(operands[0]);
+        if (operand == nullptr) {
+            return nullptr;
+        }
+        return arena->make<Unary>(get_line(node), symbol == SYM_T_LOp_NOT ? OP_NOT : OP_NEG, operand);
+    }
+    return build_terminal(node);
+}
+
+Expr *AstBuilder::build_terminal(TreeNode node) {
+    int line = get_line(node);
+
+    switch (kind(node)) {
+        case SYM_T_Decimal:
+            return arena->make<Literal>(line, T_Decimal, node.get_content());
+        case SYM_T_Hexadecimal:
+            return arena->make<Literal>(line, T_Hexadecimal, node.get_content());
+        case SYM_T_String:
+            return arena->make<Literal>(line, T_String, node.get_content());
+        case SYM_T_True:
+            return arena->make<Literal>(line, T_True, "true");
+        case SYM_T_False:
+            return arena->make<Literal>(line, T_False, "false");
+        case SYM_T_Id:
+            return arena->make<Name>(line, node.get_content());
+        default:
+            return nullptr;
+    }
+}
+
+Expr *AstBuilder::build_factor(TreeNode node) {
+    TreeNode first = child(node, 0);
+    grammar_symbol symbol = kind(first);
+    int line = get_line(first);
+
+    switch (symbol) {
+        case SYM_T_Id: {
+            // <fac_id_opt> -> T_LP <exp_ls_call> T_RP @ T_LB <exp> T_RB @ eps
+            TreeNode id_opt = child(node, 1);
+            grammar_symbol rule = kind(child(id_opt, 0));
+            if (rule == SYM_T_LP) {
+                auto *call = arena->make<Call>(line, first.get_content());
+                build_exp_ls(child(id_opt, 1), call->args);
+                return call;
+            } else if (rule == SYM_T_LB) {
+                Expr *index = build_exp(child(id_opt, 1));
+                if (index != nullptr) {
+                    return arena->make<Index>(line, first.get_content(), index);
+                }
+            }
+            return build_terminal(first);
+        }
+        case SYM_T_LP: {
+            // <fac_lparen> -> <exp> <lpar_exp_suf>, <lpar_exp_suf> -> T_RP @ T_Comma <pure_exp_ls> T_RP
+            TreeNode lparen = child(node, 1);
+            Expr *head = build_exp(child(lparen, 0));
+            TreeNode suffix = child(lparen, 1);
+            if (kind(child(suffix, 0)) != SYM_T_Comma) {
+                return head;
+            }
+
+            auto *tuple = arena->make<TupleLit>(line);
+            if (head != nullptr) {
+                tuple->elements.push_back(head);
+            }
+            for (TreeNode item: get_items(child(suffix, 1), SYM_exp)) {
+                Expr *element = build_exp(item);
+                if (element != nullptr) {
+                    tuple->elements.push_back(element);
+                }
+            }
+            return tuple;
+        }
+        case SYM_T_LB: {
+            auto *array = arena->make<ArrayLit>(line);
+            build_exp_ls(child(node, 1), array->elements);
+            return array;
+        }
+        case SYM_T_LOp_NOT:
+        case SYM_T_AOp_MN: {
+            Expr *operand = build_exp(child(node, 1));
+            if (operand == nullptr) {
+                return nullptr;
+            }
+            return arena->make<Unary>(line, symbol == SYM_T_LOp_NOT ? OP_NOT : OP_NEG, operand);
+        }
+        default:
+            return build_terminal(first);
+    }
+}
+
+void AstBuilder::build_exp_ls(TreeNode node, std::vector<Expr *> &exps) {
+    // <exp_ls_call>, <exp_ls_arr> -> <exp_ls> @ eps, <exp_ls> -> <arg_item> <exp_ls_tail> @ eps
+    if (is_empty(node)) {
+        return;
+    }
+    for (TreeNode item: get_items(child(node, 0), SYM_arg_item)) {
+        Expr *exp = build_arg_item(item);
+        if (exp != nullptr) {
+            exps.push_back(exp);
+        }
+    }
+}
+
+Expr *AstBuilder::build_arg_item(TreeNode node) {
+    // <arg_item> -> <exp> <arg_item_suffix>, <arg_item_suffix> -> T_Assign <exp> @ eps
+    Expr *target = build_exp(child(node, 0));
+    TreeNode suffix = child(node, 1);
+    if (is_empty(suffix)) {
+        return target;
+    }
+    Expr *value = build_exp(child(suffix, 1));
+    if (target == nullptr || value == nullptr) {
+        return target ? target : value;
+    }
+    return arena->make<NamedArg>(get_line(child(suffix, 0)), target, value);
+}
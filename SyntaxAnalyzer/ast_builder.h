@@ -0,0 +1,71 @@
+#ifndef AST_BUILDER_H
+#define AST_BUILDER_H
+
+#include "../utils.h"
+#include "ast.h"
+#include "parse_tree.h"
+#include "grammar_symbols.h"
+
+/*
+    Lowers the concrete LL(1) tree to the typed AST. List and operator-tail nodes arrive
+    spliced by the parser and are walked with loops, so the depth of the lowering follows
+    the nesting of the program.
+    Subtrees left incomplete by error recovery lower to nullptr and are skipped.
+
+    Nodes are told apart by their grammar_symbol: the tree's symbol ids are mapped to the
+    enum by name once per build, then every decision is a switch.
+*/
+class AstBuilder {
+private:
+    Arena *arena;
+    std::vector<grammar_symbol> kinds;
+
+    grammar_symbol kind(TreeNode node) const {
+        return node ? kinds[node.get_symbol()] : SYM_NONE;
+    }
+
+    static TreeNode child(TreeNode node, int index);
+
+    bool is_empty(TreeNode node) const;
+
+    std::vector<TreeNode> get_items(TreeNode list, grammar_symbol item) const;
+
+    static int get_line(TreeNode node);
+
+    static ast_op get_op(grammar_symbol symbol);
+
+    void build_stmts(TreeNode stmt_ls, std::vector<AstNode *> &stmts);
+
+    Block *build_block(TreeNode stmt_ls, int line);
+
+    FuncDecl *build_func(TreeNode node);
+
+    AstNode *build_stmt(TreeNode node);
+
+    Let *build_let(TreeNode node);
+
+    AstNode *build_id_stmt(TreeNode node);
+
+    If *build_if(TreeNode node);
+
+    Println *build_println(TreeNode node);
+
+    TypeExpr *build_type(TreeNode node);
+
+    Expr *build_exp(TreeNode node);
+
+    Expr *build_factor(TreeNode node);
+
+    Expr *build_terminal(TreeNode node);
+
+    void build_exp_ls(TreeNode node, std::vector<Expr *> &exps);
+
+    Expr *build_arg_item(TreeNode node);
+
+public:
+    explicit AstBuilder(Arena &_arena);
+
+    Program *build(const ParseTree &tree);
+};
+
+#endif // AST_BUILDER_H
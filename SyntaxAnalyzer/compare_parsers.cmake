@@ -0,0 +1,38 @@
+# Parses every Test/*.tr with the direct-coded parser and the parse table and fails when
+# the event logs differ. The compiler reads ../Test and writes ../Output, so the inputs are
+# copied into a scratch directory under the build tree.
+#
+# Usage: cmake -DCOMPILER=<TrustCompiler> -DTEST_DIR=<Test> -DWORK_DIR=<scratch>
+#              -DPARSER_MISMATCH=<exit code of a mismatch> -P compare_parsers.cmake
+
+file(REMOVE_RECURSE ${WORK_DIR})
+file(MAKE_DIRECTORY ${WORK_DIR}/Test ${WORK_DIR}/Output ${WORK_DIR}/run)
+file(GLOB programs RELATIVE ${TEST_DIR} ${TEST_DIR}/*.tr)
+list(SORT programs)
+file(COPY ${TEST_DIR}/Grammar.txt DESTINATION ${WORK_DIR}/Test)
+
+set(mismatches "")
+foreach (program ${programs})
+    file(COPY ${TEST_DIR}/${program} DESTINATION ${WORK_DIR}/Test)
+    file(WRITE ${WORK_DIR}/run/input.txt "${program}\n")
+    execute_process(
+            COMMAND ${COMPILER} --check --compare-parsers
+            WORKING_DIRECTORY ${WORK_DIR}/run
+            INPUT_FILE ${WORK_DIR}/run/input.txt
+            OUTPUT_QUIET
+            ERROR_VARIABLE errors
+            RESULT_VARIABLE status)
+    # syntax and lexical errors in a test program are fine, only a mismatch exits with PARSER_MISMATCH
+    if (status EQUAL PARSER_MISMATCH)
+        list(APPEND mismatches ${program})
+        message(STATUS "${program}: the parsers differ")
+    elseif (errors MATCHES "Parser Warning")
+        message(FATAL_ERROR "${program}: the direct-coded parser doesn't match Grammar.txt")
+    else ()
+        message(STATUS "${program}: same events")
+    endif ()
+endforeach ()
+
+if (mismatches)
+    message(FATAL_ERROR "The direct-coded parser and the parse table differ on: ${mismatches}")
+endif ()
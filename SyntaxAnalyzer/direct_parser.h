@@ -0,0 +1,14 @@
+#ifndef DIRECT_PARSER_H
+#define DIRECT_PARSER_H
+
+#include "syntax_analyzer.h"
+
+/*
+    Direct-coded parser written by ParserGenerator from Test/Grammar.txt into the build
+    directory. It is only compiled in when the build is configured with -DDIRECT_PARSER=ON.
+*/
+extern const uint64_t DIRECT_GRAMMAR_HASH;
+
+void direct_parse_symbol(Parser &parser, uint16_t symbol, int parent);
+
+#endif // DIRECT_PARSER_H
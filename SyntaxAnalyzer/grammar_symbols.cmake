@@ -0,0 +1,36 @@
+# Writes grammar_symbols.h: one enum constant per symbol of the grammar, so passes over the
+# parse tree switch on symbols instead of comparing names.
+#
+# Usage: cmake -DGRAMMAR=<grammar file> -DOUTPUT=<header> -P grammar_symbols.cmake
+
+file(READ ${GRAMMAR} grammar)
+
+string(REGEX MATCHALL "<[A-Za-z_][A-Za-z0-9_]*>" variables "${grammar}")
+string(REGEX MATCHALL "T_[A-Za-z0-9_]+" terminals "${grammar}")
+string(REPLACE "<" "" variables "${variables}")
+string(REPLACE ">" "" variables "${variables}")
+
+set(symbols ${terminals} eps ${variables})
+list(REMOVE_DUPLICATES symbols)
+list(SORT symbols)
+
+set(header "// Generated from Grammar.txt by grammar_symbols.cmake, do not edit.\n")
+string(APPEND header "#ifndef GRAMMAR_SYMBOLS_H\n#define GRAMMAR_SYMBOLS_H\n\n#include <cstdint>\n\n")
+string(APPEND header "enum grammar_symbol : uint16_t {\n    SYM_NONE,\n")
+foreach (symbol ${symbols})
+    string(APPEND header "    SYM_${symbol},\n")
+endforeach ()
+string(APPEND header "    NUM_GRAMMAR_SYMBOLS\n};\n\n")
+string(APPEND header "const char *const grammar_symbol_names[] = {\n        \"\",\n")
+foreach (symbol ${symbols})
+    string(APPEND header "        \"${symbol}\",\n")
+endforeach ()
+string(APPEND header "};\n\n#endif // GRAMMAR_SYMBOLS_H\n")
+
+# only touch the header when the grammar's symbols changed, so edits to rules alone rebuild nothing
+if (EXISTS ${OUTPUT})
+    file(READ ${OUTPUT} old_header)
+endif ()
+if (NOT "${old_header}" STREQUAL "${header}")
+    file(WRITE ${OUTPUT} "${header}")
+endif ()
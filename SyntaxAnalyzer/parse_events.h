@@ -0,0 +1,124 @@
+#ifndef PARSE_EVENTS_H
+#define PARSE_EVENTS_H
+
+#include "../utils.h"
+#include <cstdint>
+
+#define EVENT_KIND_BITS 2
+#define EVENT_VALUE_MASK 0x3FFFFFFFU
+
+enum event_kind {
+    EVENT_START,
+    EVENT_TOKEN,
+    EVENT_FINISH,
+    EVENT_ERROR
+};
+
+/*
+    One parser event packed in a word: the kind in the top two bits and its value below,
+    the grammar symbol for a node start and the token index for a token or an error.
+*/
+class ParseEvent {
+private:
+    uint32_t bits;
+
+public:
+    ParseEvent(event_kind kind, uint32_t value) : bits((uint32_t) kind << (32 - EVENT_KIND_BITS) | value) {}
+
+    event_kind get_kind() const {
+        return (event_kind) (bits >> (32 - EVENT_KIND_BITS));
+    }
+
+    uint32_t get_value() const {
+        return bits & EVENT_VALUE_MASK;
+    }
+
+    bool operator==(const ParseEvent &other) const {
+        return bits == other.bits;
+    }
+};
+
+/*
+    Flat log the parser writes instead of allocating tree nodes. A token event belongs to the
+    innermost open node. The parser still names parents by node id (the number of the node's
+    start event), and adding a node under a parent closes every open node below it, so the
+    finish events come out in order without the parser tracking them.
+    Validation reads the log directly; ParseTree::build materializes the tree from it.
+*/
+class ParseEvents {
+private:
+    std::vector<ParseEvent> events;
+    std::vector<int> open;
+    int num_nodes;
+
+public:
+    ParseEvents() : num_nodes(0) {}
+
+    void reset() {
+        events.clear();
+        open.clear();
+        num_nodes = 0;
+    }
+
+    // nodes must be added in preorder; parent -1 adds a root
+    int add_node(uint16_t symbol, int parent) {
+        while (!open.empty() && open.back() != parent) {
+            events.emplace_back(EVENT_FINISH, 0);
+            open.pop_back();
+        }
+        events.emplace_back(EVENT_START, symbol);
+        open.push_back(num_nodes);
+        return num_nodes++;
+    }
+
+    // adds a finished log recorded by another parser as one subtree under parent
+    void append(const ParseEvents &other, int parent) {
+        while (!open.empty() && open.back() != parent) {
+            events.emplace_back(EVENT_FINISH, 0);
+            open.pop_back();
+        }
+        events.insert(events.end(), other.events.begin(), other.events.end());
+        num_nodes += other.num_nodes;
+    }
+
+    void set_token(int token) {
+        events.emplace_back(EVENT_TOKEN, token);
+    }
+
+    void add_error(int token) {
+        events.emplace_back(EVENT_ERROR, token);
+    }
+
+    void finish() {
+        while (!open.empty()) {
+            events.emplace_back(EVENT_FINISH, 0);
+            open.pop_back();
+        }
+    }
+
+    bool operator==(const ParseEvents &other) const {
+        return events == other.events;
+    }
+
+    int size() const {
+        return (int) events.size();
+    }
+
+    const ParseEvent &operator[](int index) const {
+        return events[index];
+    }
+
+    std::vector<ParseEvent>::const_iterator begin() const {
+        return events.begin();
+    }
+
+    std::vector<ParseEvent>::const_iterator end() const {
+        return events.end();
+    }
+
+    int get_num_nodes() const {
+        return num_nodes;
+    }
+};
+
+#endif // PARSE_EVENTS_H
@@ -0,0 +1,316 @@
+#include "parse_table.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+
+static size_t align8(size_t size) {
+    return (size + 7) & ~(size_t) 7;
+}
+
+ParseTable::ParseTable() {
+    mapping = nullptr;
+    mapping_size = 0;
+    clear();
+}
+
+ParseTable::~ParseTable() {
+    release_mapping();
+}
+
+void ParseTable::release_mapping() {
+    if (mapping != nullptr) {
+        munmap(mapping, mapping_size);
+        mapping = nullptr;
+        mapping_size = 0;
+    }
+}
+
+void ParseTable::refresh_views() {
+    cell_data = cells.data();
+    rule_head_data = rule_heads.data();
+    rule_offset_data = rule_offsets.data();
+    rule_symbol_data = rule_symbols.data();
+    follow_data = follow_bits.data();
+    sync_data = sync_bits.data();
+    list_data = list_flags.data();
+}
+
+void ParseTable::clear() {
+    release_mapping();
+    num_terminals = 0;
+    num_variables = 0;
+    num_rules = 0;
+    follow_words = 0;
+    symbols.clear();
+    terminal_ids.clear();
+    variable_ids.clear();
+    cells.clear();
+    rule_heads.clear();
+    rule_offsets.assign(1, 0);
+    rule_symbols.clear();
+    follow_bits.clear();
+    sync_bits.clear();
+    list_flags.clear();
+    std::fill(token_terminals, token_terminals + Eof + 1, NO_SYMBOL);
+    refresh_views();
+}
+
+void ParseTable::set_symbols(const std::set<std::string> &terminals, const std::set<std::string> &variables) {
+    clear();
+    if (terminals.size() + variables.size() >= NO_SYMBOL) {
+        std::cerr << RED << "Grammar Error: Too many symbols for the parse table" << WHITE << std::endl;
+        exit(GRAMMAR_ERROR);
+    }
+
+    for (const auto &name: terminals) {
+        terminal_ids[name] = (uint16_t) symbols.size();
+        symbols.emplace_back(name, TERMINAL);
+    }
+    for (const auto &name: variables) {
+        variable_ids[name] = (uint16_t) symbols.size();
+        symbols.emplace_back(name, VARIABLE);
+    }
+    num_terminals = (int) terminals.size();
+    num_variables = (int) variables.size();
+    follow_words = (num_terminals + 63) / 64;
+    cells.assign((size_t) num_variables * num_terminals, EMPTY_CELL);
+    follow_bits.assign((size_t) num_variables * follow_words, 0);
+    sync_bits.assign((size_t) num_variables * follow_words, 0);
+    list_flags.assign(num_variables, 0);
+    refresh_views();
+}
+
+uint16_t ParseTable::add_rule(uint16_t head, const std::vector<uint16_t> &body) {
+    if (num_rules + 1 >= SYNCH_CELL) {
+        std::cerr << RED << "Grammar Error: Too many rules for the parse table" << WHITE << std::endl;
+        exit(GRAMMAR_ERROR);
+    }
+
+    rule_heads.push_back(head);
+    rule_symbols.insert(rule_symbols.end(), body.begin(), body.end());
+    rule_offsets.push_back((uint32_t) rule_symbols.size());
+    refresh_views();
+    return (uint16_t) num_rules++;
+}
+
+void ParseTable::set_token_terminal(token_type type, const std::string &name) {
+    token_terminals[type] = get_terminal_id(name);
+}
+
+void ParseTable::add_follow(uint16_t var, uint16_t term) {
+    follow_bits[(var - num_terminals) * follow_words + term / 64] |= (uint64_t) 1 << (term % 64);
+}
+
+void ParseTable::add_sync(uint16_t var, uint16_t term) {
+    sync_bits[(var - num_terminals) * follow_words + term / 64] |= (uint64_t) 1 << (term % 64);
+}
+
+/*
+    File layout: FileHeader, then the token map, cells, rule heads, rule offsets, rule
+    symbols, follow sets, sync sets, list flags, name offsets and the name pool, each section
+    padded to 8 bytes so it can be used in place once the file is mapped.
+*/
+bool ParseTable::save(const std::string &path, uint64_t grammar_hash) const {
+    int num_symbols = get_num_symbols();
+    std::vector<uint32_t> name_offsets(1, 0);
+    std::string names;
+    for (const auto &symbol: symbols) {
+        names += symbol.get_name();
+        name_offsets.push_back((uint32_t) names.size());
+    }
+
+    FileHeader header{};
+    header.magic = TABLE_MAGIC;
+    header.version = TABLE_VERSION;
+    header.token_types = Eof + 1;
+    header.grammar_hash = grammar_hash;
+    header.num_terminals = num_terminals;
+    header.num_variables = num_variables;
+    header.num_rules = num_rules;
+    header.num_rule_symbols = (uint32_t) rule_offset_data[num_rules];
+    header.follow_words = follow_words;
+    header.names_size = (uint32_t) names.size();
+
+    std::string buffer(align8(sizeof(FileHeader)), '\0');
+    auto append = [&buffer](const void *data, size_t size) {
+        buffer.append((const char *) data, size);
+        buffer.resize(align8(buffer.size()), '\0');
+    };
+    append(token_terminals, sizeof(token_terminals));
+    append(cell_data, sizeof(uint16_t) * num_variables * num_terminals);
+    append(rule_head_data, sizeof(uint16_t) * num_rules);
+    append(rule_offset_data, sizeof(uint32_t) * (num_rules + 1));
+    append(rule_symbol_data, sizeof(uint16_t) * header.num_rule_symbols);
+    append(follow_data, sizeof(uint64_t) * num_variables * follow_words);
+    append(sync_data, sizeof(uint64_t) * num_variables * follow_words);
+    append(list_data, sizeof(uint8_t) * num_variables);
+    append(name_offsets.data(), sizeof(uint32_t) * (num_symbols + 1));
+    append(names.data(), names.size());
+    header.file_size = buffer.size();
+    memcpy(buffer.data(), &header, sizeof(header));
+
+    // Other compiler processes may be reading the table right now, so write a private
+    // file and rename it over the old one; readers see either version, never a mix.
+    std::string tmp_path = path + ".tmp." + std::to_string(getpid());
+    std::ofstream table_file(tmp_path, std::ios::binary);
+    if (!table_file.is_open()) {
+        return false;
+    }
+    table_file.write(buffer.data(), (std::streamsize) buffer.size());
+    table_file.close();
+    if (!table_file || std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool ParseTable::load(const std::string &path, uint64_t grammar_hash) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(FileHeader)) {
+        close(fd);
+        return false;
+    }
+    size_t size = st.st_size;
+    void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+
+    const auto *header = (const FileHeader *) data;
+    if (header->magic != TABLE_MAGIC || header->version != TABLE_VERSION ||
+        header->token_types != Eof + 1 || header->grammar_hash != grammar_hash || header->file_size != size ||
+        header->num_terminals >= NO_SYMBOL || header->num_variables >= NO_SYMBOL || header->num_rules >= SYNCH_CELL) {
+        munmap(data, size);
+        return false;
+    }
+
+    size_t expected_size = align8(sizeof(FileHeader)) + align8(sizeof(token_terminals)) +
+                           align8(sizeof(uint16_t) * header->num_variables * header->num_terminals) +
+                           align8(sizeof(uint16_t) * header->num_rules) +
+                           align8(sizeof(uint32_t) * (header->num_rules + 1)) +
+                           align8(sizeof(uint16_t) * header->num_rule_symbols) +
+                           align8(sizeof(uint64_t) * header->num_variables * header->follow_words) * 2 +
+                           align8(sizeof(uint8_t) * header->num_variables) +
+                           align8(sizeof(uint32_t) * (header->num_terminals + header->num_variables + 1)) +
+                           align8(header->names_size);
+    if (expected_size != size) {
+        munmap(data, size);
+        return false;
+    }
+
+    uint32_t terms = header->num_terminals, vars = header->num_variables, rules = header->num_rules;
+    uint32_t num_symbols = terms + vars;
+    const char *cursor = (const char *) data + align8(sizeof(FileHeader));
+    auto take = [&cursor](size_t size) {
+        const char *section = cursor;
+        cursor += align8(size);
+        return section;
+    };
+    const auto *file_token_terminals = (const uint16_t *) take(sizeof(token_terminals));
+    const auto *file_cells = (const uint16_t *) take(sizeof(uint16_t) * vars * terms);
+    const auto *file_rule_heads = (const uint16_t *) take(sizeof(uint16_t) * rules);
+    const auto *file_rule_offsets = (const uint32_t *) take(sizeof(uint32_t) * (rules + 1));
+    const auto *file_rule_symbols = (const uint16_t *) take(sizeof(uint16_t) * header->num_rule_symbols);
+    const auto *file_follows = (const uint64_t *) take(sizeof(uint64_t) * vars * header->follow_words);
+    const auto *file_syncs = (const uint64_t *) take(sizeof(uint64_t) * vars * header->follow_words);
+    const auto *file_lists = (const uint8_t *) take(sizeof(uint8_t) * vars);
+    const auto *name_offsets = (const uint32_t *) take(sizeof(uint32_t) * (num_symbols + 1));
+    const char *names = take(header->names_size);
+
+    // a damaged file with the right hash would send the parser out of its arrays, so every
+    // index is checked once and anything off makes the table be built again
+    bool valid = num_symbols < NO_SYMBOL && (uint64_t) header->follow_words * 64 >= terms;
+    for (int type = 0; type <= Eof && valid; type++) {
+        valid = file_token_terminals[type] < terms || file_token_terminals[type] == NO_SYMBOL;
+    }
+    for (size_t cell = 0; cell < (size_t) vars * terms && valid; cell++) {
+        valid = file_cells[cell] < rules || file_cells[cell] == SYNCH_CELL || file_cells[cell] == EMPTY_CELL;
+    }
+    valid = valid && file_rule_offsets[0] == 0 && file_rule_offsets[rules] == header->num_rule_symbols;
+    for (uint32_t rule = 0; rule < rules && valid; rule++) {
+        valid = file_rule_heads[rule] >= terms && file_rule_heads[rule] < num_symbols &&
+                file_rule_offsets[rule] <= file_rule_offsets[rule + 1];
+    }
+    for (uint32_t i = 0; i < header->num_rule_symbols && valid; i++) {
+        valid = file_rule_symbols[i] < num_symbols;
+    }
+    valid = valid && name_offsets[0] == 0 && name_offsets[num_symbols] <= header->names_size;
+    for (uint32_t id = 0; id < num_symbols && valid; id++) {
+        valid = name_offsets[id] <= name_offsets[id + 1];
+    }
+    if (!valid) {
+        munmap(data, size);
+        return false;
+    }
+
+    clear();
+    mapping = data;
+    mapping_size = size;
+    num_terminals = (int) terms;
+    num_variables = (int) vars;
+    num_rules = (int) rules;
+    follow_words = (int) header->follow_words;
+    memcpy(token_terminals, file_token_terminals, sizeof(token_terminals));
+    cell_data = file_cells;
+    rule_head_data = file_rule_heads;
+    rule_offset_data = file_rule_offsets;
+    rule_symbol_data = file_rule_symbols;
+    follow_data = file_follows;
+    sync_data = file_syncs;
+    list_data = file_lists;
+
+    for (int id = 0; id < (int) num_symbols; id++) {
+        std::string name(names + name_offsets[id], name_offsets[id + 1] - name_offsets[id]);
+        if (id < num_terminals) {
+            terminal_ids[name] = id;
+            symbols.emplace_back(name, TERMINAL);
+        } else {
+            variable_ids[name] = id;
+            symbols.emplace_back(name, VARIABLE);
+        }
+    }
+    return true;
+}
+
+uint16_t ParseTable::get_id(const Symbol &symbol) const {
+    if (symbol.get_type() == TERMINAL) {
+        return get_terminal_id(symbol.get_name());
+    }
+    return get_variable_id(symbol.get_name());
+}
+
+uint16_t ParseTable::get_terminal_id(const std::string &name) const {
+    auto it = terminal_ids.find(name);
+    return it == terminal_ids.end() ? NO_SYMBOL : it->second;
+}
+
+uint16_t ParseTable::get_variable_id(const std::string &name) const {
+    auto it = variable_ids.find(name);
+    return it == variable_ids.end() ? NO_SYMBOL : it->second;
+}
+
+std::string ParseTable::cell_to_string(uint16_t cell) const {
+    if (cell == SYNCH_CELL) {
+        return "SYNCH";
+    }
+    if (cell == EMPTY_CELL) {
+        return "EMPTY";
+    }
+
+    std::string res = "<" + get_name(rule_head_data[cell]) + "> -> ";
+    for (const uint16_t *part = body_begin(cell); part != body_end(cell); part++) {
+        Symbol symbol = symbols[*part];
+        res += symbol.toString() + " ";
+    }
+    return res;
+}
@@ -0,0 +1,177 @@
+#ifndef PARSE_TABLE_H
+#define PARSE_TABLE_H
+
+#include "../utils.h"
+#include <cstdint>
+
+#define SYNCH_CELL 0xFFFE
+#define EMPTY_CELL 0xFFFF
+#define NO_SYMBOL 0xFFFF
+
+#define TABLE_MAGIC 0x314C4C5453555254ULL // "TRUSTLL1"
+#define TABLE_VERSION 3
+
+/*
+    Dense LL(1) table.
+
+    Terminals are numbered [0, num_terminals) and variables [num_terminals, num_symbols),
+    both in name order. Each cell holds a rule id, SYNCH_CELL or EMPTY_CELL, and rule bodies
+    live back to back in rule_symbols, so the parser does one load per step and never copies
+    a rule. List variables are the nullable ones with a right-recursive rule (stmt_ls,
+    *_tail, ...); the parser splices their recursion into one node. The sync set of a
+    variable holds the terminals where error recovery for it stops skipping: those with a
+    rule or SYNCH cell, and $.
+
+    The arrays are either owned (while the table is being built from the grammar) or point
+    straight into a mapped table file written by save().
+*/
+class ParseTable {
+private:
+    struct FileHeader {
+        uint64_t magic;
+        uint32_t version;
+        uint32_t token_types;
+        uint64_t grammar_hash;
+        uint32_t num_terminals;
+        uint32_t num_variables;
+        uint32_t num_rules;
+        uint32_t num_rule_symbols;
+        uint32_t follow_words;
+        uint32_t names_size;
+        uint64_t file_size;
+    };
+
+    int num_terminals;
+    int num_variables;
+    int num_rules;
+    int follow_words;
+    std::vector<Symbol> symbols;
+    std::map<std::string, uint16_t> terminal_ids, variable_ids;
+    uint16_t token_terminals[Eof + 1];
+
+    std::vector<uint16_t> cells;
+    std::vector<uint16_t> rule_heads;
+    std::vector<uint32_t> rule_offsets;
+    std::vector<uint16_t> rule_symbols;
+    std::vector<uint64_t> follow_bits;
+    std::vector<uint64_t> sync_bits;
+    std::vector<uint8_t> list_flags;
+
+    const uint16_t *cell_data;
+    const uint16_t *rule_head_data;
+    const uint32_t *rule_offset_data;
+    const uint16_t *rule_symbol_data;
+    const uint64_t *follow_data;
+    const uint64_t *sync_data;
+    const uint8_t *list_data;
+
+    void *mapping;
+    size_t mapping_size;
+
+    void refresh_views();
+
+    void release_mapping();
+
+public:
+    ParseTable();
+
+    ~ParseTable();
+
+    ParseTable(const ParseTable &) = delete;
+
+    ParseTable &operator=(const ParseTable &) = delete;
+
+    void clear();
+
+    void set_symbols(const std::set<std::string> &terminals, const std::set<std::string> &variables);
+
+    uint16_t add_rule(uint16_t head, const std::vector<uint16_t> &body);
+
+    void set_token_terminal(token_type type, const std::string &name);
+
+    void add_follow(uint16_t var, uint16_t term);
+
+    void add_sync(uint16_t var, uint16_t term);
+
+    void set_list(uint16_t var) {
+        list_flags[var - num_terminals] = 1;
+    }
+
+    bool save(const std::string &path, uint64_t grammar_hash) const;
+
+    bool load(const std::string &path, uint64_t grammar_hash);
+
+    uint16_t get_id(const Symbol &symbol) const;
+
+    uint16_t get_terminal_id(const std::string &name) const;
+
+    uint16_t get_variable_id(const std::string &name) const;
+
+    const Symbol &get_symbol(uint16_t id) const {
+        return symbols[id];
+    }
+
+    const std::string &get_name(uint16_t id) const {
+        return symbols[id].get_name();
+    }
+
+    bool is_terminal(uint16_t id) const {
+        return id < num_terminals;
+    }
+
+    int get_num_terminals() const {
+        return num_terminals;
+    }
+
+    int get_num_variables() const {
+        return num_variables;
+    }
+
+    int get_num_symbols() const {
+        return num_terminals + num_variables;
+    }
+
+    int get_num_rules() const {
+        return num_rules;
+    }
+
+    uint16_t get_terminal(token_type type) const {
+        return token_terminals[type];
+    }
+
+    uint16_t get_cell(uint16_t var, uint16_t term) const {
+        return cell_data[(var - num_terminals) * num_terminals + term];
+    }
+
+    void set_cell(uint16_t var, uint16_t term, uint16_t value) {
+        cells[(var - num_terminals) * num_terminals + term] = value;
+    }
+
+    bool in_follow(uint16_t var, uint16_t term) const {
+        return follow_data[(var - num_terminals) * follow_words + term / 64] >> (term % 64) & 1;
+    }
+
+    bool in_sync(uint16_t var, uint16_t term) const {
+        return sync_data[(var - num_terminals) * follow_words + term / 64] >> (term % 64) & 1;
+    }
+
+    bool is_list(uint16_t var) const {
+        return list_data[var - num_terminals];
+    }
+
+    uint16_t get_rule_head(uint16_t rule) const {
+        return rule_head_data[rule];
+    }
+
+    const uint16_t *body_begin(uint16_t rule) const {
+        return rule_symbol_data + rule_offset_data[rule];
+    }
+
+    const uint16_t *body_end(uint16_t rule) const {
+        return rule_symbol_data + rule_offset_data[rule + 1];
+    }
+
+    std::string cell_to_string(uint16_t cell) const;
+};
+
+#endif // PARSE_TABLE_H
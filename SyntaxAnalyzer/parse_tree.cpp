@@ -0,0 +1,250 @@
+#include "parse_tree.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+
+static size_t align8(size_t size) {
+    return (size + 7) & ~(size_t) 7;
+}
+
+ParseTree::ParseTree() {
+    mapping = nullptr;
+    mapping_size = 0;
+    reset(nullptr, nullptr);
+}
+
+ParseTree::~ParseTree() {
+    release_mapping();
+}
+
+void ParseTree::release_mapping() {
+    if (mapping != nullptr) {
+        munmap(mapping, mapping_size);
+        mapping = nullptr;
+        mapping_size = 0;
+    }
+}
+
+void ParseTree::refresh_views() {
+    symbol_data = symbols.data();
+    token_index_data = token_indices.data();
+    subtree_size_data = subtree_sizes.data();
+    parent_data = parents.data();
+    num_nodes = (int) symbols.size();
+}
+
+void ParseTree::reset(const ParseTable *_table, const std::vector<Token> *_tokens) {
+    release_mapping();
+    table = _table;
+    tokens = _tokens;
+    symbols.clear();
+    token_indices.clear();
+    subtree_sizes.clear();
+    parents.clear();
+    num_terminals = table != nullptr ? table->get_num_terminals() : 0;
+    grammar_hash = 0;
+    names.clear();
+    num_tokens = 0;
+    line_data = nullptr;
+    content_offsets = nullptr;
+    pool = nullptr;
+    refresh_views();
+}
+
+void ParseTree::finish() {
+    for (int id = (int) symbols.size() - 1; id > 0; id--) {
+        subtree_sizes[parents[id]] += subtree_sizes[id];
+    }
+    refresh_views();
+}
+
+void ParseTree::build(const ParseTable *_table, const std::vector<Token> *_tokens, const ParseEvents &events) {
+    reset(_table, _tokens);
+    symbols.reserve(events.get_num_nodes());
+    token_indices.reserve(events.get_num_nodes());
+    subtree_sizes.reserve(events.get_num_nodes());
+    parents.reserve(events.get_num_nodes());
+
+    int current = -1;
+    for (const ParseEvent &event: events) {
+        switch (event.get_kind()) {
+            case EVENT_START:
+                current = add_node(event.get_value(), current);
+                break;
+            case EVENT_TOKEN:
+                set_token(current, (int) event.get_value());
+                break;
+            case EVENT_FINISH:
+                current = parents[current];
+                break;
+            default:
+                break;
+        }
+    }
+    finish();
+}
+
+/*
+    File layout: FileHeader, then per node the symbol ids, token indices, subtree sizes and
+    parents, per token its line number and content offset, the symbol name
+    offsets and one string pool with the names followed by the token contents. Every section
+    is padded to 8 bytes so it can be used in place once the file is mapped.
+*/
+bool ParseTree::save(const std::string &path, uint64_t _grammar_hash) const {
+    int num_symbols = get_num_symbols();
+    int token_count = get_num_tokens();
+
+    std::string strings;
+    std::vector<uint32_t> name_offsets(1, 0);
+    for (int symbol = 0; symbol < num_symbols; symbol++) {
+        strings += symbol_name(symbol);
+        name_offsets.push_back((uint32_t) strings.size());
+    }
+    std::vector<int32_t> lines;
+    std::vector<uint32_t> contents(1, (uint32_t) strings.size());
+    lines.reserve(token_count);
+    contents.reserve(token_count + 1);
+    for (int token = 0; token < token_count; token++) {
+        lines.push_back(token_line(token));
+        strings += token_content(token);
+        contents.push_back((uint32_t) strings.size());
+    }
+
+    FileHeader header{};
+    header.magic = TREE_MAGIC;
+    header.version = TREE_VERSION;
+    header.num_nodes = num_nodes;
+    header.grammar_hash = _grammar_hash;
+    header.num_terminals = num_terminals;
+    header.num_symbols = num_symbols;
+    header.num_tokens = token_count;
+    header.pool_size = (uint32_t) strings.size();
+
+    std::string buffer(align8(sizeof(FileHeader)), '\0');
+    auto append = [&buffer](const void *data, size_t size) {
+        buffer.append((const char *) data, size);
+        buffer.resize(align8(buffer.size()), '\0');
+    };
+    append(symbol_data, sizeof(uint16_t) * num_nodes);
+    append(token_index_data, sizeof(int32_t) * num_nodes);
+    append(subtree_size_data, sizeof(uint32_t) * num_nodes);
+    append(parent_data, sizeof(int32_t) * num_nodes);
+    append(lines.data(), sizeof(int32_t) * token_count);
+    append(contents.data(), sizeof(uint32_t) * (token_count + 1));
+    append(name_offsets.data(), sizeof(uint32_t) * (num_symbols + 1));
+    append(strings.data(), strings.size());
+    header.file_size = buffer.size();
+    memcpy(buffer.data(), &header, sizeof(header));
+
+    // a reader may have the old tree mapped, so the new one replaces it by a rename
+    std::string tmp_path = path + ".tmp." + std::to_string(getpid());
+    std::ofstream tree_file(tmp_path, std::ios::binary);
+    if (!tree_file.is_open()) {
+        return false;
+    }
+    tree_file.write(buffer.data(), (std::streamsize) buffer.size());
+    tree_file.close();
+    if (!tree_file || std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool ParseTree::load(const std::string &path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(FileHeader)) {
+        close(fd);
+        return false;
+    }
+    size_t size = st.st_size;
+    void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+
+    const auto *header = (const FileHeader *) data;
+    size_t nodes = header->num_nodes;
+    size_t expected_size = align8(sizeof(FileHeader)) + align8(sizeof(uint16_t) * nodes) +
+                           align8(sizeof(int32_t) * nodes) * 3 +
+                           align8(sizeof(int32_t) * header->num_tokens) +
+                           align8(sizeof(uint32_t) * ((size_t) header->num_tokens + 1)) +
+                           align8(sizeof(uint32_t) * ((size_t) header->num_symbols + 1)) +
+                           align8(header->pool_size);
+    if (header->magic != TREE_MAGIC || header->version != TREE_VERSION || header->file_size != size ||
+        expected_size != size || header->num_terminals > header->num_symbols || nodes == 0) {
+        munmap(data, size);
+        return false;
+    }
+
+    const char *cursor = (const char *) data + align8(sizeof(FileHeader));
+    auto take = [&cursor](size_t size) {
+        const char *section = cursor;
+        cursor += align8(size);
+        return section;
+    };
+    const auto *file_symbols = (const uint16_t *) take(sizeof(uint16_t) * nodes);
+    const auto *file_tokens = (const int32_t *) take(sizeof(int32_t) * nodes);
+    const auto *file_subtree_sizes = (const uint32_t *) take(sizeof(uint32_t) * nodes);
+    const auto *file_parents = (const int32_t *) take(sizeof(int32_t) * nodes);
+    const auto *file_lines = (const int32_t *) take(sizeof(int32_t) * header->num_tokens);
+    const auto *file_contents = (const uint32_t *) take(sizeof(uint32_t) * (header->num_tokens + 1));
+    const auto *name_offsets = (const uint32_t *) take(sizeof(uint32_t) * (header->num_symbols + 1));
+    const char *file_pool = take(header->pool_size);
+
+    // the file may come from another tool, so the indices and the shape are checked once
+    // before the arrays are used in place
+    bool valid = true;
+    for (uint32_t i = 0; i < header->num_symbols && valid; i++) {
+        valid = name_offsets[i] <= name_offsets[i + 1];
+    }
+    valid = valid && name_offsets[header->num_symbols] <= header->pool_size;
+    valid = valid && file_contents[0] >= name_offsets[header->num_symbols];
+    for (uint32_t i = 0; i < header->num_tokens && valid; i++) {
+        valid = file_contents[i] <= file_contents[i + 1];
+    }
+    valid = valid && file_contents[header->num_tokens] <= header->pool_size;
+    for (size_t id = 0; id < nodes && valid; id++) {
+        valid = file_symbols[id] < header->num_symbols && file_tokens[id] < (int32_t) header->num_tokens &&
+                (id == 0 ? file_parents[id] == -1 : file_parents[id] >= 0 && (size_t) file_parents[id] < id);
+    }
+    if (valid) {
+        std::vector<uint32_t> sizes(nodes, 1);
+        for (size_t id = nodes - 1; id > 0; id--) {
+            sizes[file_parents[id]] += sizes[id];
+        }
+        valid = memcmp(sizes.data(), file_subtree_sizes, sizeof(uint32_t) * nodes) == 0;
+    }
+    if (!valid) {
+        munmap(data, size);
+        return false;
+    }
+
+    reset(nullptr, nullptr);
+    mapping = data;
+    mapping_size = size;
+    symbol_data = file_symbols;
+    token_index_data = file_tokens;
+    subtree_size_data = file_subtree_sizes;
+    parent_data = file_parents;
+    num_nodes = (int) nodes;
+    num_terminals = (int) header->num_terminals;
+    grammar_hash = header->grammar_hash;
+    num_tokens = (int) header->num_tokens;
+    line_data = file_lines;
+    content_offsets = file_contents;
+    pool = file_pool;
+    for (uint32_t symbol = 0; symbol < header->num_symbols; symbol++) {
+        names.emplace_back(file_pool + name_offsets[symbol], name_offsets[symbol + 1] - name_offsets[symbol]);
+    }
+    return true;
+}
@@ -0,0 +1,338 @@
+#ifndef PARSE_TREE_H
+#define PARSE_TREE_H
+
+#include "../utils.h"
+#include "parse_table.h"
+#include "parse_events.h"
+
+#define TREE_MAGIC 0x4E59535453555254ULL // "TRUSTSYN"
+#define TREE_VERSION 2
+
+class ParseTree;
+
+class ChildRange;
+
+/*
+    Handle to one node of a ParseTree. It is two words wide and copied by value; all data
+    lives in the tree's arrays.
+*/
+class TreeNode {
+private:
+    const ParseTree *tree;
+    int id;
+
+public:
+    TreeNode() : tree(nullptr), id(-1) {}
+
+    TreeNode(const ParseTree *_tree, int _id) : tree(_tree), id(_id) {}
+
+    int get_id() const {
+        return id;
+    }
+
+    explicit operator bool() const {
+        return tree != nullptr && id >= 0;
+    }
+
+    bool operator==(const TreeNode &other) const {
+        return id == other.id && tree == other.tree;
+    }
+
+    bool operator!=(const TreeNode &other) const {
+        return !(*this == other);
+    }
+
+    inline uint16_t get_symbol() const;
+
+    inline const std::string &get_name() const;
+
+    inline symbol_type get_type() const;
+
+    inline std::string get_content() const;
+
+    inline int get_line_number() const;
+
+    inline TreeNode get_parent() const;
+
+    inline ChildRange get_children() const;
+
+    inline std::string toString() const;
+};
+
+/*
+    The children of a node, walked through subtree sizes: the first child follows its
+    parent, every sibling starts right after the previous sibling's subtree and the last
+    one ends where the parent's subtree does. Nothing is stored or allocated; counting and
+    indexing walk from the first child.
+*/
+class ChildRange {
+private:
+    const ParseTree *tree;
+    int first;
+    int last; // one past the parent's subtree
+
+public:
+    class iterator {
+    private:
+        const ParseTree *tree;
+        int id;
+
+    public:
+        iterator(const ParseTree *_tree, int _id) : tree(_tree), id(_id) {}
+
+        TreeNode operator*() const {
+            return {tree, id};
+        }
+
+        inline iterator &operator++();
+
+        bool operator==(const iterator &other) const {
+            return id == other.id;
+        }
+
+        bool operator!=(const iterator &other) const {
+            return id != other.id;
+        }
+    };
+
+    ChildRange(const ParseTree *_tree, int _first, int _last) : tree(_tree), first(_first), last(_last) {}
+
+    iterator begin() const {
+        return {tree, first};
+    }
+
+    iterator end() const {
+        return {tree, last};
+    }
+
+    int size() const {
+        int count = 0;
+        for (auto it = begin(); it != end(); ++it) {
+            count++;
+        }
+        return count;
+    }
+
+    bool empty() const {
+        return first >= last;
+    }
+
+    // an empty handle past the last child
+    inline TreeNode operator[](int index) const;
+};
+
+/*
+    Parse tree stored in preorder as parallel arrays: grammar symbol id, token index (the
+    matched token for terminals, the lookahead at expansion for variables, -1 if none),
+    subtree size and parent, 14 bytes a node. The node at index 0 is the root. Anything
+    else known about a node, such as its content, line or type, is looked up through its
+    token or kept in the AST.
+
+    Like the parse table, the arrays are either owned (built from a parser event log, names
+    and token text come from the table and the token stream) or point straight into a mapped
+    .synb file written by save(), which carries its own names and token text.
+*/
+class ParseTree {
+private:
+    struct FileHeader {
+        uint64_t magic;
+        uint32_t version;
+        uint32_t num_nodes;
+        uint64_t grammar_hash;
+        uint32_t num_terminals;
+        uint32_t num_symbols;
+        uint32_t num_tokens;
+        uint32_t pool_size;
+        uint64_t file_size;
+    };
+
+    const ParseTable *table;
+    const std::vector<Token> *tokens;
+    std::vector<uint16_t> symbols;
+    std::vector<int32_t> token_indices;
+    std::vector<uint32_t> subtree_sizes;
+    std::vector<int32_t> parents;
+
+    const uint16_t *symbol_data;
+    const int32_t *token_index_data;
+    const uint32_t *subtree_size_data;
+    const int32_t *parent_data;
+    int num_nodes;
+    int num_terminals;
+
+    // only used by a tree loaded from a file
+    uint64_t grammar_hash;
+    std::vector<std::string> names;
+    int num_tokens;
+    const int32_t *line_data;
+    const uint32_t *content_offsets;
+    const char *pool;
+
+    void *mapping;
+    size_t mapping_size;
+
+    void refresh_views();
+
+    void release_mapping();
+
+    const std::string &symbol_name(uint16_t symbol) const {
+        return table != nullptr ? table->get_name(symbol) : names[symbol];
+    }
+
+    int get_num_tokens() const {
+        return tokens != nullptr ? (int) tokens->size() : num_tokens;
+    }
+
+    std::string token_content(int token) const {
+        if (tokens != nullptr) {
+            return (*tokens)[token].get_content();
+        }
+        return {pool + content_offsets[token], content_offsets[token + 1] - content_offsets[token]};
+    }
+
+    int token_line(int token) const {
+        return tokens != nullptr ? (*tokens)[token].get_line_number() : line_data[token];
+    }
+
+public:
+    ParseTree();
+
+    ~ParseTree();
+
+    ParseTree(const ParseTree &) = delete;
+
+    ParseTree &operator=(const ParseTree &) = delete;
+
+    void reset(const ParseTable *_table, const std::vector<Token> *_tokens);
+
+    // nodes must be added in preorder
+    int add_node(uint16_t symbol, int parent) {
+        symbols.push_back(symbol);
+        token_indices.push_back(-1);
+        subtree_sizes.push_back(1);
+        parents.push_back(parent);
+        return (int) symbols.size() - 1;
+    }
+
+    void set_token(int id, int token) {
+        token_indices[id] = token;
+    }
+
+    void finish();
+
+    // materializes the tree recorded in a parser event log
+    void build(const ParseTable *_table, const std::vector<Token> *_tokens, const ParseEvents &events);
+
+    bool save(const std::string &path, uint64_t _grammar_hash) const;
+
+    bool load(const std::string &path);
+
+    int size() const {
+        return num_nodes;
+    }
+
+    bool empty() const {
+        return num_nodes == 0;
+    }
+
+    TreeNode get_root() const {
+        return {this, empty() ? -1 : 0};
+    }
+
+    int get_num_symbols() const {
+        return table != nullptr ? table->get_num_symbols() : (int) names.size();
+    }
+
+    const std::string &get_symbol_name(uint16_t symbol) const {
+        return symbol_name(symbol);
+    }
+
+    // the hash of the grammar a loaded tree was parsed with
+    uint64_t get_grammar_hash() const {
+        return grammar_hash;
+    }
+
+    uint16_t get_symbol(int id) const {
+        return symbol_data[id];
+    }
+
+    int get_token_index(int id) const {
+        return token_index_data[id];
+    }
+
+    int get_subtree_size(int id) const {
+        return (int) subtree_size_data[id];
+    }
+
+    int get_parent(int id) const {
+        return parent_data[id];
+    }
+
+    const std::string &get_name(int id) const {
+        return symbol_name(symbol_data[id]);
+    }
+
+    symbol_type get_type(int id) const {
+        return symbol_data[id] < num_terminals ? TERMINAL : VARIABLE;
+    }
+
+    std::string get_content(int id) const {
+        if (token_index_data[id] < 0 || get_type(id) != TERMINAL) {
+            return "";
+        }
+        return token_content(token_index_data[id]);
+    }
+
+    int get_line_number(int id) const {
+        return token_index_data[id] < 0 ? -1 : token_line(token_index_data[id]);
+    }
+};
+
+uint16_t TreeNode::get_symbol() const {
+    return tree->get_symbol(id);
+}
+
+// a missing node (an empty handle) reads as a nameless, contentless leaf
+const std::string &TreeNode::get_name() const {
+    static const std::string none;
+    return *this ? tree->get_name(id) : none;
+}
+
+symbol_type TreeNode::get_type() const {
+    return tree->get_type(id);
+}
+
+std::string TreeNode::get_content() const {
+    return *this ? tree->get_content(id) : "";
+}
+
+int TreeNode::get_line_number() const {
+    return *this ? tree->get_line_number(id) : -1;
+}
+
+TreeNode TreeNode::get_parent() const {
+    return {tree, tree->get_parent(id)};
+}
+
+ChildRange TreeNode::get_children() const {
+    return {tree, id + 1, *this ? id + tree->get_subtree_size(id) : id + 1};
+}
+
+std::string TreeNode::toString() const {
+    return get_type() == TERMINAL ? get_name() : "<" + get_name() + ">";
+}
+
+ChildRange::iterator &ChildRange::iterator::operator++() {
+    id += tree->get_subtree_size(id);
+    return *this;
+}
+
+TreeNode ChildRange::operator[](int index) const {
+    int id = first;
+    for (int i = 0; i < index && id < last; i++) {
+        id += tree->get_subtree_size(id);
+    }
+    return id < last ? TreeNode(tree, id) : TreeNode();
+}
+
+#endif // PARSE_TREE_H
@@ -0,0 +1,498 @@
+#include "parser.h"
+#include "syntax_analyzer.h"
+
+#ifdef DIRECT_PARSER
+#include "direct_parser.h"
+#endif
+
+Parser::Parser(const SyntaxAnalyzer &analyzer, std::ostream &_err) : table(analyzer.table), tokens(analyzer.tokens),
+                                                                    match(analyzer.match),
+                                                                    exp_id(analyzer.exp_id),
+                                                                    operand_id(analyzer.operand_id),
+                                                                    func_id(analyzer.func_id),
+                                                                    eps_id(analyzer.table.get_id(eps)),
+                                                                    direct(analyzer.direct), err(_err) {
+    max_errors = analyzer.max_errors;
+    fast = false;
+    failed = false;
+    error_pos = -1;
+    errors_at_pos = 0;
+    index = 0;
+    end = (int) tokens.size();
+    num_errors = 0;
+    functions = nullptr;
+    next_function = 0;
+}
+
+void Parser::parse_program() {
+    uint16_t start_id = table.get_variable_id(START_VAR);
+    if (!fast_pass(start_id, -1)) {
+        parse_symbol(start_id, -1);
+    }
+    parse_symbol(table.get_terminal(Eof), -2);
+    events.finish();
+}
+
+/*
+    Worker side: parses <func> from function.begin on its own, as the main parse would if it
+    got there. The worker may look at the next function's T_Fn but stops before going past
+    it; a parse that reached the limit is incomplete and left to the main parse, so no
+    token is parsed by more than two workers and the total work stays linear.
+*/
+void Parser::parse_function(FunctionParse &function) {
+    index = function.begin;
+    end = function.limit;
+    if (!fast_pass(func_id, -1)) {
+        parse_symbol(func_id, -1);
+    }
+    events.finish();
+    function.complete = index < end || end == (int) tokens.size();
+    function.end = index;
+    function.events = std::move(events);
+    function.num_errors = num_errors;
+    function.error_pos = error_pos;
+    function.errors_at_pos = errors_at_pos;
+}
+
+// main side: splices in the worker's <func> when one was parsed from the current token
+bool Parser::take_function(int parent) {
+    if (functions == nullptr) {
+        return false;
+    }
+    while (next_function < functions->size() && (*functions)[next_function].begin < index) {
+        next_function++;
+    }
+    if (next_function == functions->size() || (*functions)[next_function].begin != index ||
+        !(*functions)[next_function].complete) {
+        return false;
+    }
+
+    const FunctionParse &function = (*functions)[next_function];
+    if (fast && function.num_errors) {
+        failed = true;
+        return true;
+    }
+    // the worker started without the main parse's error state; take it only where that doesn't matter
+    if (num_errors + function.num_errors >= max_errors || error_pos == index) {
+        return false;
+    }
+    next_function++;
+    events.append(function.events, parent);
+    err << function.diagnostics;
+    num_errors += function.num_errors;
+    if (function.num_errors) {
+        error_pos = function.error_pos;
+        errors_at_pos = function.errors_at_pos;
+    }
+    index = function.end;
+    return true;
+}
+
+/*
+    Runs the fast path over symbol, which must start a fresh event log. On the first error
+    the log and position are rolled back and false is returned, so the caller parses again
+    with recovery and full diagnostics. The direct-coded parser has no table lookups to
+    save and always takes the recovery path.
+*/
+bool Parser::fast_pass(uint16_t symbol, int parent) {
+    if (!FAST_PARSER || direct) {
+        return false;
+    }
+
+    int begin = index;
+    fast = true;
+    failed = false;
+    fast_parse_symbol(symbol, parent);
+    fast = false;
+    if (!failed) {
+        return true;
+    }
+
+    events.reset();
+    index = begin;
+    next_function = 0;
+    failed = false;
+    return false;
+}
+
+void Parser::parse_symbol(uint16_t symbol, int parent) {
+    if (fast) {
+        fast_parse_symbol(symbol, parent);
+        return;
+    }
+#ifdef DIRECT_PARSER
+    if (direct) {
+        direct_parse_symbol(*this, symbol, parent);
+        return;
+    }
+#endif
+    table_parse_symbol(symbol, parent);
+}
+
+/*
+    Every error goes through here. A token may cause at most MAX_ERRORS_PER_TOKEN errors
+    before recovery is pushed past it, so recovery work stays linear in the input. An error
+    at $ or the max_errors-th error stops the parse: the position jumps to the end of the
+    tokens and whatever is still predicted is closed as leaves. Returns false once stopped.
+*/
+bool Parser::count_error(int pos) {
+    events.add_error(pos);
+    num_errors++;
+    if (pos == error_pos) {
+        errors_at_pos++;
+    } else {
+        error_pos = pos;
+        errors_at_pos = 1;
+    }
+
+    if (num_errors >= max_errors) {
+        err << RED << "Syntax Error: Too many errors, parsing stopped after " << num_errors << WHITE << std::endl;
+        index = end;
+        return false;
+    }
+    if (tokens[pos].get_type() == Eof) {
+        index = end;
+        return false;
+    }
+    return true;
+}
+
+// terminal mismatch: the terminal is dropped by the caller
+void Parser::report_mismatch(uint16_t expected) {
+    err << RED << "Syntax Error: Terminals don't match, line: " << tokens[index].get_line_number() << WHITE
+        << std::endl;
+    err << RED << "Expected '" << table.get_name(expected) << "', but found '"
+        << match.at(tokens[index].get_type()) << "' with content '"
+        << tokens[index].get_content() << "' instead." << WHITE << std::endl;
+    if (count_error(index) && errors_at_pos > MAX_ERRORS_PER_TOKEN) {
+        index++;
+    }
+}
+
+// SYNCH cell: the token can follow the variable, which is dropped by the caller
+void Parser::synchronize() {
+    err << RED << "Syntax Error: Synchronization attempted, line: " << tokens[index].get_line_number() << WHITE
+        << std::endl;
+    if (count_error(index) && errors_at_pos > MAX_ERRORS_PER_TOKEN) {
+        index++;
+    }
+}
+
+// EMPTY cell: skip to the next token in the sync set of var; var stays on the stack
+void Parser::skip_unexpected(uint16_t var) {
+    err << RED << "Syntax Error: Unexpected input or missing rule, line: " << tokens[index].get_line_number()
+        << WHITE << std::endl;
+    if (!count_error(index)) {
+        return;
+    }
+
+    uint16_t term;
+    do {
+        index++;
+        term = index < end ? table.get_terminal(tokens[index].get_type()) : NO_SYMBOL;
+    } while (index < end && (term == NO_SYMBOL || !table.in_sync(var, term)));
+}
+
+/*
+    Table-driven parse of one symbol under parent, from the current token on.
+
+    Nodes get their preorder id when first popped; the $ sentinel (parent -2) never does.
+    Right-recursive list rules (stmt_ls, func_ls, *_tail, ...) are spliced: the trailing
+    recursive variable is pushed with its parent's id, so its expansion adds children to
+    the same node. A list of n items is one node holding the n items and whatever ends
+    the recursion (eps for most lists), and the tree depth follows the nesting of the
+    program instead of the length of its lists.
+*/
+void Parser::table_parse_symbol(uint16_t symbol, int parent) {
+    std::stack<ParseItem> stack;
+    stack.push({symbol, parent, -1});
+
+    while (index < end && !stack.empty()) {
+        ParseItem top = stack.top();
+        stack.pop();
+        if (top.id < 0 && top.symbol == func_id && take_function(top.parent)) {
+            continue;
+        }
+        if (top.id < 0 && top.parent != -2) {
+            top.id = events.add_node(top.symbol, top.parent);
+        }
+        if (top.symbol == eps_id) {
+            continue;
+        }
+
+        uint16_t term = table.get_terminal(tokens[index].get_type());
+        int line_number = tokens[index].get_line_number();
+
+        if (DEBUG_PARSER) {
+            err << "[DEBUG] Processing token[" << index << "]: " << tokens[index].get_content() << " (line "
+                << line_number << "), top of stack: " << table.get_name(top.symbol) << std::endl;
+        }
+
+        if (table.is_terminal(top.symbol)) {
+            if (term == top.symbol) {
+                if (top.id >= 0) {
+                    events.set_token(index);
+                }
+                index++;
+            } else {
+                report_mismatch(top.symbol);
+            }
+            continue;
+        }
+
+        uint16_t cell = term == NO_SYMBOL ? EMPTY_CELL : table.get_cell(top.symbol, term);
+        if (cell < SYNCH_CELL) {
+            if (top.parent != top.id) {
+                events.set_token(index);
+            }
+            if (top.symbol == exp_id) {
+                parse_expression(top.id);
+                continue;
+            }
+
+            const uint16_t *body_begin = table.body_begin(cell);
+            for (const uint16_t *part = table.body_end(cell); part != body_begin;) {
+                part--;
+                if (*part == top.symbol && part + 1 == table.body_end(cell) && table.is_list(top.symbol)) {
+                    stack.push({*part, top.id, top.id});
+                } else {
+                    stack.push({*part, top.id, -1});
+                }
+            }
+        } else if (cell == SYNCH_CELL) {
+            synchronize();
+        } else {
+            skip_unexpected(top.symbol);
+            stack.push(top);
+        }
+    }
+
+    // whatever is left was predicted but never reached; it stays in the tree as leaves
+    while (!stack.empty()) {
+        ParseItem top = stack.top();
+        stack.pop();
+        if (top.id < 0 && top.parent != -2) {
+            events.add_node(top.symbol, top.parent);
+        }
+    }
+}
+
+/*
+    table_parse_symbol for well-formed input: the same steps without recovery or bounds
+    checks. Any mismatch or non-rule cell sets failed and returns at once. $ is never
+    predicted inside the grammar, so no prediction can consume the last token, and the loop
+    can never run past the end of the token stream.
+*/
+void Parser::fast_parse_symbol(uint16_t symbol, int parent) {
+    std::vector<ParseItem> stack;
+    stack.reserve(64);
+    stack.push_back({symbol, parent, -1});
+
+    while (!stack.empty()) {
+        ParseItem top = stack.back();
+        stack.pop_back();
+        if (top.id < 0) {
+            if (top.symbol == func_id && take_function(top.parent)) {
+                if (failed) {
+                    return;
+                }
+                continue;
+            }
+            top.id = events.add_node(top.symbol, top.parent);
+        }
+        if (top.symbol == eps_id) {
+            continue;
+        }
+
+        uint16_t term = table.get_terminal(tokens[index].get_type());
+        if (table.is_terminal(top.symbol)) {
+            if (term != top.symbol) {
+                failed = true;
+                return;
+            }
+            events.set_token(index);
+            index++;
+            continue;
+        }
+
+        uint16_t cell = term == NO_SYMBOL ? EMPTY_CELL : table.get_cell(top.symbol, term);
+        if (cell >= SYNCH_CELL) {
+            failed = true;
+            return;
+        }
+        if (top.parent != top.id) {
+            events.set_token(index);
+        }
+        if (top.symbol == exp_id) {
+            parse_expression(top.id);
+            if (failed) {
+                return;
+            }
+            continue;
+        }
+
+        const uint16_t *body_begin = table.body_begin(cell);
+        for (const uint16_t *part = table.body_end(cell); part != body_begin;) {
+            part--;
+            if (*part == top.symbol && part + 1 == table.body_end(cell) && table.is_list(top.symbol)) {
+                stack.push_back({*part, top.id, top.id});
+            } else {
+                stack.push_back({*part, top.id, -1});
+            }
+        }
+    }
+}
+
+int Parser::binary_precedence(token_type type) {
+    switch (type) {
+        case T_LOp_OR:
+            return 1;
+        case T_LOp_AND:
+            return 2;
+        case T_ROp_E:
+        case T_ROp_NE:
+            return 3;
+        case T_ROp_L:
+        case T_ROp_LE:
+        case T_ROp_G:
+        case T_ROp_GE:
+            return 4;
+        case T_AOp_Trust:
+        case T_AOp_MN:
+            return 5;
+        case T_AOp_ML:
+        case T_AOp_DV:
+        case T_AOp_RM:
+            return 6;
+        default:
+            return 0;
+    }
+}
+
+// the token after the bracket group opened at pos, or the first token that can't be inside an expression
+int Parser::skip_group(int pos) {
+    int depth = 0;
+    int tokens_len = static_cast<int>(tokens.size());
+    for (; pos < tokens_len; pos++) {
+        token_type type = tokens[pos].get_type();
+        if (type == T_LP || type == T_LB) {
+            depth++;
+        } else if (type == T_RP || type == T_RB) {
+            if (--depth == 0) {
+                return pos + 1;
+            }
+        } else if (type == T_Semicolon || type == T_LC || type == T_RC || type == Eof) {
+            return pos;
+        }
+    }
+    return pos;
+}
+
+bool Parser::can_follow_exp(int pos) {
+    uint16_t term = table.get_terminal(tokens[pos].get_type());
+    return tokens[pos].get_type() == Eof || (term != NO_SYMBOL && table.in_follow(exp_id, term));
+}
+
+int Parser::scan_operand(std::vector<ExpNode> &nodes, int &pos) {
+    token_type type = tokens[pos].get_type();
+    if (type == T_LOp_NOT || type == T_AOp_MN) {
+        int op = pos++;
+        int operand = scan_operand(nodes, pos);
+        nodes.push_back({op, -1, -1, operand, -1});
+        return (int) nodes.size() - 1;
+    }
+
+    int begin = pos;
+    if (type == T_Id) {
+        pos++;
+        if (tokens[pos].get_type() == T_LP || tokens[pos].get_type() == T_LB) {
+            pos = skip_group(pos);
+        }
+    } else if (type == T_LP || type == T_LB) {
+        pos = skip_group(pos);
+    } else if (type == T_Decimal || type == T_Hexadecimal || type == T_String || type == T_True ||
+               type == T_False) {
+        pos++;
+    }
+    nodes.push_back({-1, begin, pos, -1, -1});
+    return (int) nodes.size() - 1;
+}
+
+int Parser::scan_binary(std::vector<ExpNode> &nodes, int &pos, int min_precedence) {
+    int lhs = scan_operand(nodes, pos);
+    while (true) {
+        int precedence = binary_precedence(tokens[pos].get_type());
+        if (precedence == 0 && !can_follow_exp(pos)) {
+            if (fast) {
+                failed = true;
+                return lhs;
+            }
+            // the table parser fails the same way on the *_exp_tail variables: report and skip
+            err << RED << "Syntax Error: Unexpected input or missing rule, line: "
+                << tokens[pos].get_line_number() << WHITE << std::endl;
+            if (!count_error(pos)) {
+                break;
+            }
+            pos++;
+            continue;
+        }
+        if (precedence == 0 || precedence < min_precedence) {
+            break;
+        }
+        int op = pos++;
+        int rhs = scan_binary(nodes, pos, precedence + 1);
+        nodes.push_back({op, -1, -1, lhs, rhs});
+        lhs = (int) nodes.size() - 1;
+    }
+    return lhs;
+}
+
+/*
+    <exp> is parsed by precedence climbing instead of the table. The tokens are first scanned
+    into an operator tree whose leaves are operand token ranges, found by bracket matching;
+    the tree is then emitted under parent in preorder, one node per operator or operand:
+    binary and prefix operators are their operator terminals with the operands as children,
+    a literal or a bare name is its terminal, and any other operand (call, index, parentheses,
+    array) is an <exp_operand> subtree parsed by the table, which comes back here for the
+    expressions nested inside it.
+*/
+void Parser::parse_expression(int parent) {
+    std::vector<ExpNode> nodes;
+    int expr_end = index;
+    int root = scan_binary(nodes, expr_end, 1);
+    if (failed) {
+        return;
+    }
+
+    std::vector<std::pair<int, int>> pending = {{root, parent}};
+    while (!pending.empty()) {
+        auto [node_id, node_parent] = pending.back();
+        pending.pop_back();
+        const ExpNode &node = nodes[node_id];
+
+        if (node.token >= 0) {
+            int id = events.add_node(table.get_terminal(tokens[node.token].get_type()), node_parent);
+            events.set_token(node.token);
+            if (node.rhs >= 0) {
+                pending.emplace_back(node.rhs, id);
+            }
+            pending.emplace_back(node.lhs, id);
+            continue;
+        }
+
+        // operators are read out of order, so every operand starts from its own first token
+        index = std::max(index, node.begin);
+        if (index == node.begin && node.end == node.begin + 1 && tokens[index].get_type() != T_LP &&
+            tokens[index].get_type() != T_LB) {
+            events.add_node(table.get_terminal(tokens[index].get_type()), node_parent);
+            events.set_token(index);
+            index++;
+        } else {
+            parse_symbol(operand_id, node_parent);
+            if (failed) {
+                return;
+            }
+        }
+    }
+    index = std::max(index, expr_end);
+}
@@ -0,0 +1,100 @@
+#ifndef PARSER_H
+#define PARSER_H
+
+#include "../utils.h"
+#include "parse_table.h"
+#include "parse_events.h"
+
+class SyntaxAnalyzer;
+
+struct ParseItem {
+    uint16_t symbol;
+    int parent;
+    int id;
+};
+
+// operator tree node of parse_expression: an operator token with its operands, or an operand token range
+struct ExpNode {
+    int token;
+    int begin;
+    int end;
+    int lhs;
+    int rhs;
+};
+
+// a top-level function parsed ahead by a worker: the log of <func> parsed from begin on
+struct FunctionParse {
+    int begin;
+    int limit = 0;
+    int end = 0;
+    bool complete = false;
+    ParseEvents events;
+    int num_errors = 0;
+    int error_pos = -1, errors_at_pos = 0;
+    std::string diagnostics;
+
+    explicit FunctionParse(int _begin) : begin(_begin) {}
+};
+
+/*
+    One parse over the token stream of a SyntaxAnalyzer. The table, tokens and symbol ids
+    are only read, so several parsers can run on worker threads at once; each one owns its
+    position, event log, error count and the stream its diagnostics go to.
+*/
+class Parser {
+public:
+    const ParseTable &table;
+    const std::vector<Token> &tokens;
+    const std::map<token_type, std::string> &match;
+    uint16_t exp_id, operand_id, func_id, eps_id;
+    bool direct;
+    bool fast;
+    bool failed;
+    std::ostream &err;
+    ParseEvents events;
+    int index;
+    int end;
+    int num_errors;
+    int max_errors;
+    int error_pos, errors_at_pos;
+    const std::vector<FunctionParse> *functions;
+    size_t next_function;
+
+    Parser(const SyntaxAnalyzer &analyzer, std::ostream &_err);
+
+    void parse_program();
+
+    void parse_function(FunctionParse &function);
+
+    bool take_function(int parent);
+
+    bool fast_pass(uint16_t symbol, int parent);
+
+    void parse_symbol(uint16_t symbol, int parent);
+
+    bool count_error(int pos);
+
+    void report_mismatch(uint16_t expected);
+
+    void synchronize();
+
+    void skip_unexpected(uint16_t var);
+
+    void table_parse_symbol(uint16_t symbol, int parent);
+
+    void fast_parse_symbol(uint16_t symbol, int parent);
+
+    static int binary_precedence(token_type type);
+
+    int skip_group(int pos);
+
+    bool can_follow_exp(int pos);
+
+    int scan_operand(std::vector<ExpNode> &nodes, int &pos);
+
+    int scan_binary(std::vector<ExpNode> &nodes, int &pos, int min_precedence);
+
+    void parse_expression(int parent);
+};
+
+#endif // PARSER_H
@@ -0,0 +1,184 @@
+#include "syntax_analyzer.h"
+
+/*
+    Writes the direct-coded parser: every variable of the grammar becomes a function whose
+    switch over the lookahead terminal replaces the table lookup. The functions follow the
+    table driver step for step (list splicing, the <exp> hand-over to parse_expression and
+    error recovery), so both backends write the same event log for any input.
+
+    Usage: ParserGenerator <grammar file> <output file>
+*/
+
+static std::string function_name(const ParseTable &table, uint16_t var) {
+    return "parse_" + table.get_name(var);
+}
+
+static void write_body(std::ostream &out, const ParseTable &table, uint16_t var, uint16_t rule, bool list) {
+    const std::string indent = "                    ";
+    uint16_t eps_id = table.get_id(eps);
+
+    if (list) {
+        out << indent << "if (!spliced) {\n"
+            << indent << "    events.set_token(index);\n"
+            << indent << "}\n";
+    } else {
+        out << indent << "events.set_token(index);\n";
+    }
+    if (table.get_name(var) == EXP_VAR) {
+        out << indent << "parser.parse_expression(id);\n"
+            << indent << "return;\n";
+        return;
+    }
+
+    for (const uint16_t *part = table.body_begin(rule); part != table.body_end(rule); part++) {
+        if (list && *part == var && part + 1 == table.body_end(rule)) {
+            out << indent << "spliced = true;\n"
+                << indent << "continue;\n";
+            return;
+        }
+        if (*part == eps_id) {
+            out << indent << "events.add_node(" << *part << ", id);\n";
+        } else if (table.is_terminal(*part)) {
+            out << indent << "expect(" << *part << ", id); // " << table.get_name(*part) << "\n";
+        } else {
+            out << indent << function_name(table, *part) << "(id);\n";
+        }
+    }
+    out << indent << "return;\n";
+}
+
+static void write_variable(std::ostream &out, const ParseTable &table, uint16_t var) {
+    bool list = table.is_list(var);
+
+    // cells with the same rule become one group of case labels
+    std::map<uint16_t, std::vector<uint16_t>> cases;
+    for (int term = 0; term < table.get_num_terminals(); term++) {
+        uint16_t cell = table.get_cell(var, term);
+        if (cell != EMPTY_CELL) {
+            cases[cell].push_back(term);
+        }
+    }
+
+    out << "    void " << function_name(table, var) << "(int parent) {\n";
+    if (table.get_name(var) == FUNC_VAR) {
+        out << "        if (parser.take_function(parent)) {\n"
+            << "            return;\n"
+            << "        }\n";
+    }
+    out << "        if (index >= tokens_len) {\n"
+        << "            events.add_node(" << var << ", parent);\n"
+        << "            return;\n"
+        << "        }\n"
+        << "        int id = events.add_node(" << var << ", parent);\n";
+    if (list) {
+        out << "        bool spliced = false;\n";
+    }
+    out << "        while (index < tokens_len) {\n"
+        << "            switch (lookahead()) {\n";
+    for (const auto &it: cases) {
+        for (uint16_t term: it.second) {
+            out << "                case " << term << ": // " << table.get_name(term) << "\n";
+        }
+        if (it.first == SYNCH_CELL) {
+            out << "                    parser.synchronize();\n"
+                << "                    return;\n";
+        } else {
+            out << "                    // " << strip(table.cell_to_string(it.first)) << "\n";
+            write_body(out, table, var, it.first, list);
+        }
+    }
+    out << "                default:\n"
+        << "                    parser.skip_unexpected(" << var << ");\n"
+        << "                    break;\n"
+        << "            }\n"
+        << "        }\n"
+        << "    }\n\n";
+}
+
+static void write_parser(std::ostream &out, const ParseTable &table, uint64_t grammar_hash) {
+    out << "// Generated by ParserGenerator from Grammar.txt, do not edit.\n"
+        << "#include \"direct_parser.h\"\n\n"
+        << "const uint64_t DIRECT_GRAMMAR_HASH = " << grammar_hash << "ULL;\n\n"
+        << "namespace {\n\n"
+        << "class DirectParser {\n"
+        << "private:\n"
+        << "    Parser &parser;\n"
+        << "    ParseEvents &events;\n"
+        << "    int &index;\n"
+        << "    int tokens_len;\n\n"
+        << "    uint16_t lookahead() const {\n"
+        << "        return parser.table.get_terminal(parser.tokens[index].get_type());\n"
+        << "    }\n\n"
+        << "    void expect(uint16_t term, int parent) {\n"
+        << "        if (index >= tokens_len) {\n"
+        << "            if (parent != -2) {\n"
+        << "                events.add_node(term, parent);\n"
+        << "            }\n"
+        << "            return;\n"
+        << "        }\n"
+        << "        int id = parent == -2 ? -1 : events.add_node(term, parent);\n"
+        << "        if (lookahead() == term) {\n"
+        << "            if (id >= 0) {\n"
+        << "                events.set_token(index);\n"
+        << "            }\n"
+        << "            index++;\n"
+        << "        } else {\n"
+        << "            parser.report_mismatch(term);\n"
+        << "        }\n"
+        << "    }\n\n"
+        << "public:\n"
+        << "    explicit DirectParser(Parser &_parser) : parser(_parser), events(_parser.events), index(_parser.index),\n"
+        << "                                            tokens_len(_parser.end) {}\n\n";
+
+    for (int var = table.get_num_terminals(); var < table.get_num_symbols(); var++) {
+        write_variable(out, table, var);
+    }
+
+    out << "    void parse_symbol(uint16_t symbol, int parent) {\n"
+        << "        switch (symbol) {\n";
+    for (int var = table.get_num_terminals(); var < table.get_num_symbols(); var++) {
+        out << "            case " << var << ":\n"
+            << "                " << function_name(table, var) << "(parent);\n"
+            << "                break;\n";
+    }
+    out << "            default:\n"
+        << "                expect(symbol, parent);\n"
+        << "                break;\n"
+        << "        }\n"
+        << "    }\n"
+        << "};\n\n"
+        << "}\n\n"
+        << "void direct_parse_symbol(Parser &parser, uint16_t symbol, int parent) {\n"
+        << "    DirectParser(parser).parse_symbol(symbol, parent);\n"
+        << "}\n";
+}
+
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        std::cerr << RED << "Usage: ParserGenerator <grammar file> <output file>" << WHITE << std::endl;
+        return FAILURE;
+    }
+
+    std::ifstream in(argv[1]);
+    if (!in.is_open()) {
+        std::cerr << RED << "File Error: Couldn't open grammar input file" << WHITE << std::endl;
+        return FILE_ERROR;
+    }
+    std::stringstream grammar;
+    grammar << in.rdbuf();
+    in.close();
+
+    SyntaxAnalyzer analyzer;
+    analyzer.build_table(grammar.str());
+
+    std::stringstream parser;
+    write_parser(parser, analyzer.table, hash_string(grammar.str()));
+
+    std::ofstream out(argv[2]);
+    if (!out.is_open()) {
+        std::cerr << RED << "File Error: Couldn't open parser output file" << WHITE << std::endl;
+        return FILE_ERROR;
+    }
+    out << parser.str();
+    return SUCCESS;
+}
@@ -1,4 +1,10 @@
 #include "syntax_analyzer.h"
+#include <atomic>
+#include <thread>
+
+#ifdef DIRECT_PARSER
+#include "direct_parser.h"
+#endif
 
 
 Rule::Rule() {
@@ -55,8 +61,25 @@ std::ostream &operator<<(std::ostream &out, Rule &rule) {
 SyntaxAnalyzer::SyntaxAnalyzer(std::vector<Token> _tokens, std::string output_file) {
     tokens = std::move(_tokens);
     out_address = std::move(output_file);
+    ast = nullptr;
+    direct = false;
+    compare_parsers = CHECK_DIRECT_PARSER;
+    set_matches();
     update_grammar();
     num_errors = 0;
+    max_errors = MAX_ERRORS;
+    format = TREE_BOX;
+}
+
+SyntaxAnalyzer::SyntaxAnalyzer() {
+    ast = nullptr;
+    direct = false;
+    compare_parsers = CHECK_DIRECT_PARSER;
+    grammar_hash = 0;
+    num_errors = 0;
+    max_errors = MAX_ERRORS;
+    format = TREE_BOX;
+    set_matches();
 }
 
 void SyntaxAnalyzer::extract(std::string line) {
@@ -116,145 +139,164 @@ void SyntaxAnalyzer::extract(std::string line) {
             rule.add_to_body(tmp);
         }
         rules.push_back(rule);
-        self_rules[rule.get_head()].push_back(rule);
     }
 }
 
+/*
+    FIRST sets and nullability as one worklist fixpoint over rules: whenever a symbol's
+    FIRST set grows or it becomes nullable, only the rules that mention it are revisited.
+*/
 void SyntaxAnalyzer::calc_firsts() {
-    for (const auto &term: terminals) {
-        calc_first(term);
+    int num_symbols = table.get_num_symbols();
+    int num_terminals = table.get_num_terminals();
+    int num_rules = table.get_num_rules();
+    uint16_t eps_id = table.get_id(eps);
+
+    firsts.assign(num_symbols, Bitset(num_terminals));
+    nullable.assign(num_symbols, false);
+    for (int term = 0; term < num_terminals; term++) {
+        if (term == eps_id) {
+            nullable[term] = true;
+        } else {
+            firsts[term].set(term);
+        }
     }
-    for (const auto &var: variables) {
-        calc_first(var);
+
+    std::vector<std::vector<uint16_t>> users(num_symbols);
+    for (int rule = 0; rule < num_rules; rule++) {
+        for (const uint16_t *part = table.body_begin(rule); part != table.body_end(rule); part++) {
+            if (users[*part].empty() || users[*part].back() != rule) {
+                users[*part].push_back(rule);
+            }
+        }
     }
-}
 
-void SyntaxAnalyzer::calc_first(const Symbol &var) {
-    if (var.get_type() == TERMINAL) {
-        firsts[var].insert(var);
-        first_done[var] = true;
-        return;
+    std::vector<uint16_t> worklist;
+    std::vector<bool> queued(num_rules, true);
+    for (int rule = num_rules - 1; rule >= 0; rule--) {
+        worklist.push_back(rule);
     }
 
-    for (auto &rule: self_rules[var]) {
-        bool exist_eps = false;
-        for (auto &part_body: rule.get_body()) {
-            if (!first_done[part_body]) {
-                calc_first(part_body);
-            }
-            exist_eps = false;
-            for (const auto &first: firsts[part_body]) {
-                if (first == eps) {
-                    exist_eps = true;
-                } else {
-                    firsts[var].insert(first);
-                }
-            }
-            if (!exist_eps) {
+    while (!worklist.empty()) {
+        uint16_t rule = worklist.back();
+        worklist.pop_back();
+        queued[rule] = false;
+
+        uint16_t head = table.get_rule_head(rule);
+        bool changed = false, all_nullable = true;
+        for (const uint16_t *part = table.body_begin(rule); part != table.body_end(rule); part++) {
+            changed |= firsts[head].merge(firsts[*part]);
+            if (!nullable[*part]) {
+                all_nullable = false;
                 break;
             }
         }
-        if (exist_eps) {
-            firsts[var].insert(eps);
+        if (all_nullable && !nullable[head]) {
+            nullable[head] = true;
+            changed = true;
+        }
+
+        if (changed) {
+            for (uint16_t user: users[head]) {
+                if (!queued[user]) {
+                    queued[user] = true;
+                    worklist.push_back(user);
+                }
+            }
         }
     }
-    first_done[var] = true;
 }
 
 void SyntaxAnalyzer::print_firsts() {
-    for (const auto &term: terminals) {
-        print_first(term);
-    }
-    for (const auto &var: variables) {
-        print_first(var);
+    for (int id = 0; id < table.get_num_symbols(); id++) {
+        print_first(id);
     }
 }
 
-void SyntaxAnalyzer::print_first(const Symbol &var) {
-    std::cout << "First[" + var.get_name() + "]:";
-    for (auto first: firsts[var]) {
-        std::cout << " " << first;
+void SyntaxAnalyzer::print_first(uint16_t id) {
+    std::cout << "First[" + table.get_name(id) + "]:";
+    firsts[id].for_each([this](int term) {
+        std::cout << " " << table.get_name(term);
+    });
+    if (nullable[id]) {
+        std::cout << " " << eps.get_name();
     }
     std::cout << std::endl;
 }
 
+/*
+    One pass over the rules collects what each body position contributes directly (FIRST of
+    the suffix after it) and records an edge head -> var when that suffix is nullable; the
+    FOLLOW sets of heads are then pushed along those edges until nothing changes.
+*/
 void SyntaxAnalyzer::calc_follows() {
-    for (const auto &var: variables) {
-        if (var.get_name() == START_VAR) {
-            follows[var].insert(Symbol("$", TERMINAL));
-        }
-        calc_follow(var);
-    }
-    relaxation();
-}
-
-void SyntaxAnalyzer::calc_follow(const Symbol &var) {
-    for (auto &rule: rules) {
-        std::vector<Symbol> &body = rule.get_body();
-        int body_len = (int) body.size();
-
-        for (int i = 0; i < body_len; i++) {
-            if (body[i] == var) {
-                bool all_eps = true;
-                for (int j = i + 1; j < body_len; j++) {
-                    bool has_eps = false;
-                    for (const auto &first: firsts[body[j]]) {
-                        if (first == eps) {
-                            has_eps = true;
-                        } else {
-                            follows[var].insert(first);
-                        }
-                    }
-                    if (!has_eps) {
-                        all_eps = false;
-                        break;
-                    }
-                }
-                if (all_eps && rule.get_head() != var) {
-                    for (const auto &follow: follows[rule.get_head()]) {
-                        follows[var].insert(follow);
-                    }
-                    graph[rule.get_head()].insert(var);
+    int num_symbols = table.get_num_symbols();
+    int num_terminals = table.get_num_terminals();
+    int num_rules = table.get_num_rules();
+
+    follows.assign(num_symbols, Bitset(num_terminals));
+    follows[table.get_variable_id(START_VAR)].set(table.get_terminal(Eof));
+
+    std::vector<std::vector<uint16_t>> graph(num_symbols);
+    for (int rule = 0; rule < num_rules; rule++) {
+        uint16_t head = table.get_rule_head(rule);
+        Bitset trailer(num_terminals);
+        bool trailer_nullable = true;
+        for (const uint16_t *part = table.body_end(rule); part != table.body_begin(rule);) {
+            part--;
+            if (!table.is_terminal(*part)) {
+                follows[*part].merge(trailer);
+                if (trailer_nullable && *part != head) {
+                    graph[head].push_back(*part);
                 }
             }
+            if (nullable[*part]) {
+                trailer.merge(firsts[*part]);
+            } else {
+                trailer = firsts[*part];
+                trailer_nullable = false;
+            }
         }
     }
-}
 
-void SyntaxAnalyzer::relaxation() {
-    std::set<Symbol> set;
-    for (const auto &var: variables) {
-        set.insert(var);
+    std::vector<uint16_t> worklist;
+    std::vector<bool> queued(num_symbols, false);
+    for (int var = num_symbols - 1; var >= num_terminals; var--) {
+        worklist.push_back(var);
+        queued[var] = true;
     }
 
-    while (!set.empty()) {
-        Symbol var = *set.begin();
-        set.erase(set.begin());
+    while (!worklist.empty()) {
+        uint16_t var = worklist.back();
+        worklist.pop_back();
+        queued[var] = false;
 
-        for (const auto &v: graph[var]) {
-            int old_size = (int) follows[v].size();
-            for (const auto &follow: follows[var]) {
-                follows[v].insert(follow);
-            }
-            int new_size = (int) follows[v].size();
-            if (new_size > old_size) {
-                set.insert(v);
+        for (uint16_t next: graph[var]) {
+            if (follows[next].merge(follows[var]) && !queued[next]) {
+                queued[next] = true;
+                worklist.push_back(next);
             }
         }
     }
+
+    for (int var = num_terminals; var < num_symbols; var++) {
+        follows[var].for_each([this, var](int term) {
+            table.add_follow(var, term);
+        });
+    }
 }
 
 void SyntaxAnalyzer::print_follows() {
-    for (const auto &var: variables) {
-        print_follow(var);
+    for (int id = table.get_num_terminals(); id < table.get_num_symbols(); id++) {
+        print_follow(id);
     }
 }
 
-void SyntaxAnalyzer::print_follow(const Symbol &var) {
-    std::cout << "Follow[" + var.get_name() + "]:";
-    for (auto follow: follows[var]) {
-        std::cout << " " << follow;
-    }
+void SyntaxAnalyzer::print_follow(uint16_t id) {
+    std::cout << "Follow[" + table.get_name(id) + "]:";
+    follows[id].for_each([this](int term) {
+        std::cout << " " << table.get_name(term);
+    });
     std::cout << std::endl;
 }
 
@@ -312,158 +354,137 @@ void SyntaxAnalyzer::set_matches() {
     match[Eof] = "$";
 }
 
-void SyntaxAnalyzer::make_table() {
+void SyntaxAnalyzer::number_symbols() {
+    std::set<std::string> terminal_names, variable_names;
+    for (const auto &term: terminals) {
+        terminal_names.insert(term.get_name());
+    }
+    for (const auto &it: match) {
+        terminal_names.insert(it.second);
+    }
+    for (const auto &var: variables) {
+        variable_names.insert(var.get_name());
+    }
+
+    table.set_symbols(terminal_names, variable_names);
+    for (const auto &it: match) {
+        table.set_token_terminal(it.first, it.second);
+    }
+
     for (auto &rule: rules) {
-        std::vector<Symbol> &body = rule.get_body();
-        Symbol head = rule.get_head();
+        std::vector<uint16_t> body;
+        for (const auto &part: rule.get_body()) {
+            body.push_back(table.get_id(part));
+        }
+        table.add_rule(table.get_id(rule.get_head()), body);
+    }
+}
+
+void SyntaxAnalyzer::set_table_cell(uint16_t head, uint16_t term, uint16_t rule) {
+    uint16_t old_rule = table.get_cell(head, term);
+    if (old_rule < SYNCH_CELL && old_rule != rule) {
+        num_conflicts++;
+        std::cerr << YELLOW << "Grammar Warning: LL(1) conflict for <" << table.get_name(head) << "> on '"
+                  << table.get_name(term) << "'\n"
+                  << "  - " << table.cell_to_string(old_rule) << "\n"
+                  << "  - " << table.cell_to_string(rule) << "(kept)" << WHITE << std::endl;
+    }
+    table.set_cell(head, term, rule);
+}
+
+void SyntaxAnalyzer::make_table() {
+    num_conflicts = 0;
+    int num_terminals = table.get_num_terminals();
+    int num_rules = table.get_num_rules();
+    for (int rule = 0; rule < num_rules; rule++) {
+        uint16_t head = table.get_rule_head(rule);
+        Bitset body_first(num_terminals);
         bool all_eps = true;
-        for (const auto &part_body: body) {
-            bool has_eps = false;
-            for (const auto &first: firsts[part_body]) {
-                if (first == eps) {
-                    has_eps = true;
-                } else {
-                    table[{head, first}] = rule;
-                }
-            }
-            if (!has_eps) {
+        for (const uint16_t *part = table.body_begin(rule); part != table.body_end(rule); part++) {
+            body_first.merge(firsts[*part]);
+            if (!nullable[*part]) {
                 all_eps = false;
                 break;
             }
         }
 
+        body_first.for_each([this, head, rule](int term) {
+            set_table_cell(head, term, rule);
+        });
         if (all_eps) {
-            for (const Symbol &var: follows[rule.get_head()]) {
-                table[{rule.get_head(), var}] = rule;
-            }
+            follows[head].for_each([this, head, rule](int term) {
+                set_table_cell(head, term, rule);
+            });
         } else {
-            for (const Symbol &var: follows[rule.get_head()]) {
-                if (table[{rule.get_head(), var}].get_type() != VALID) {
-                    table[{rule.get_head(), var}] = Rule(SYNCH);
+            follows[head].for_each([this, head](int term) {
+                if (table.get_cell(head, term) >= SYNCH_CELL) {
+                    table.set_cell(head, term, SYNCH_CELL);
                 }
-            }
+            });
         }
     }
 
-    Symbol semicolon = Symbol(";", TERMINAL);
-    Symbol closed_curly = Symbol("}", TERMINAL);
-    for (const auto &var: variables) {
-        if (table[{var, semicolon}].get_type() != VALID) {
-            table[{var, semicolon}] = Rule(SYNCH);
+    uint16_t semicolon = table.get_terminal_id(";");
+    uint16_t closed_curly = table.get_terminal_id("}");
+    for (int head = num_terminals; head < table.get_num_symbols(); head++) {
+        if (semicolon != NO_SYMBOL && table.get_cell(head, semicolon) >= SYNCH_CELL) {
+            table.set_cell(head, semicolon, SYNCH_CELL);
         }
-        if (table[{var, closed_curly}].get_type() != VALID) {
-            table[{var, closed_curly}] = Rule(SYNCH);
+        if (closed_curly != NO_SYMBOL && table.get_cell(head, closed_curly) >= SYNCH_CELL) {
+            table.set_cell(head, closed_curly, SYNCH_CELL);
         }
     }
-}
-
-void SyntaxAnalyzer::write_table() {
-    std::ofstream table_file;
-    table_file.open(TABLE_PATH);
-    if (!table_file.is_open()) {
-        std::cerr << RED << "File Error: Couldn't open table file for write" << WHITE << std::endl;
-        exit(FILE_ERROR);
-    }
-    for (auto &col: table) {
-        Symbol head1 = col.first.first;
-        Symbol head2 = col.first.second;
-        Rule rule = col.second;
 
-        table_file << "# " << head1 << ' ' << head2 << '\n';
-        table_file << rule << '\n';
+    if (num_conflicts) {
+        std::cerr << YELLOW << "Grammar Warning: The grammar is not LL(1), " << num_conflicts
+                  << " conflicting table cell(s) were overwritten" << WHITE << std::endl;
     }
-
-    table_file.close();
 }
 
-void SyntaxAnalyzer::read_table() {
-    std::ifstream table_file;
-    table_file.open(TABLE_PATH);
-    if (!table_file.is_open()) {
-        std::cerr << RED << "File Error: Couldn't open table file for read" << WHITE << std::endl;
-        exit(FILE_ERROR);
-    }
-
-    std::string line;
-    Symbol head1("", VARIABLE), head2("", TERMINAL);
-    while (getline(table_file, line)) {
-        line = strip(line);
-        std::vector<std::string> line_parts = split(line);
-        int part_rules = (int) line_parts.size();
-        if (line_parts[0] != "SYNCH" && line_parts[0] != "EMPTY" && part_rules < 3) {
-            std::cerr << RED << "Table Error: Invalid table in file" << WHITE << std::endl;
-            exit(GRAMMAR_ERROR);
+void SyntaxAnalyzer::mark_lists() {
+    for (int rule = 0; rule < table.get_num_rules(); rule++) {
+        uint16_t head = table.get_rule_head(rule);
+        if (nullable[head] && table.body_begin(rule) != table.body_end(rule) && table.body_end(rule)[-1] == head) {
+            table.set_list(head);
         }
+    }
+}
 
-        if (line_parts[0] == "#") {
-            head1.set_name(line_parts[1]);
-            head2.set_name(line_parts[2].substr(1, (int) line_parts[2].size() - 2));
-        } else if (line_parts[0] == "SYNCH") {
-            Rule rule(SYNCH);
-            table[{head1, head2}] = rule;
-        } else if (line_parts[0] == "EMPTY") {
-            Rule rule(EMPTY);
-            table[{head1, head2}] = rule;
-        } else {
-            Symbol head(line_parts[0], VARIABLE), tmp;
-            Rule rule(VALID);
-            rule.set_head(head);
-
-            for (int i = 2; i < part_rules; i++) {
-                if (line_parts[i][0] == '<') {
-                    tmp.set_name(line_parts[i].substr(1, line_parts[i].size() - 2));
-                    tmp.set_type(VARIABLE);
-                } else {
-                    tmp.set_name(line_parts[i]);
-                    tmp.set_type(TERMINAL);
-                }
-                rule.add_to_body(tmp);
+void SyntaxAnalyzer::make_sync_sets() {
+    uint16_t eof_id = table.get_terminal(Eof);
+    for (int var = table.get_num_terminals(); var < table.get_num_symbols(); var++) {
+        for (int term = 0; term < table.get_num_terminals(); term++) {
+            if (term == eof_id || table.get_cell(var, term) != EMPTY_CELL) {
+                table.add_sync(var, term);
             }
-            table[{head1, head2}] = rule;
         }
     }
-    table_file.close();
 }
 
-void SyntaxAnalyzer::write_tree(Node<Symbol> *node, int num, bool last) {
-    Symbol var = node->get_data();
-
-    for (int i = 0; i < num * 4 - 4; i++) {
-        if (has_par[i]) {
-            out << "│";
-        } else {
-            out << " ";
-        }
-    }
-    if (num) {
-        if (last) {
-            out << "└── ";
-        } else {
-            out << "├── ";
-        }
-    }
-    out << var << "\n";
-    if (!node->get_data().get_content().empty()) {
-        for (int i = 0; i < num * 4; i++) {
-            if (has_par[i]) {
-                out << "│";
-            } else {
-                out << " ";
-            }
-        }
-        out << "└── '" << node->get_data().get_content() << "'" << "\n";
+void SyntaxAnalyzer::write_table(uint64_t grammar_hash) {
+    if (!table.save(TABLE_PATH, grammar_hash)) {
+        std::cerr << YELLOW << "File Warning: Couldn't write table file, it will be rebuilt on the next run" << WHITE
+                  << std::endl;
     }
+}
+
+bool SyntaxAnalyzer::read_table(uint64_t grammar_hash) {
+    return table.load(TABLE_PATH, grammar_hash);
+}
 
-    has_par[num * 4] = true;
-    std::deque<Node<Symbol> *> children = node->get_children();
-    for (auto child: children) {
-        bool end = false;
-        if (child == children.back()) {
-            has_par[num * 4] = false;
-            end = true;
+void SyntaxAnalyzer::write_tree(std::ostream &stream) {
+    OutputSink sink(stream);
+    auto describe = [](TreeNode node, TreeLabel &label) {
+        label.name = node.toString();
+        label.content = node.get_content();
+        label.line = node.get_line_number();
+    };
+    auto children = [](TreeNode node, std::vector<TreeNode> &list) {
+        for (TreeNode child: node.get_children()) {
+            list.push_back(child);
         }
-        write_tree(child, num + 1, end);
-    }
+    };
+    print_tree(sink, tree.get_root(), format, describe, children);
 }
 
 void SyntaxAnalyzer::update_grammar() {
@@ -473,130 +494,57 @@ void SyntaxAnalyzer::update_grammar() {
         std::cerr << RED << "File Error: Couldn't open grammar input file" << WHITE << std::endl;
         exit(FILE_ERROR);
     }
+    std::stringstream grammar;
+    grammar << in.rdbuf();
+    in.close();
 
-    std::string line;
-    while (getline(in, line)) {
-        if (!line.empty()) {
-            extract(line);
-        }
+    std::string grammar_text = grammar.str();
+    grammar_hash = hash_string(grammar_text);
+    if (read_table(grammar_hash)) {
+        return;
     }
-    in.close();
 
+    build_table(grammar_text);
+    write_table(grammar_hash);
+}
+
+void SyntaxAnalyzer::build_table(const std::string &grammar_text) {
+    rules.clear();
+    variables.clear();
+    terminals.clear();
+
+    for (const auto &line: split(grammar_text, ENDL)) {
+        extract(line);
+    }
+
+    number_symbols();
     calc_firsts();
     calc_follows();
     make_table();
-    write_table();
+    mark_lists();
+    make_sync_sets();
 }
 
 void SyntaxAnalyzer::make_tree(bool update) {
-    std::cerr << "[DEBUG] Entering make_tree(" << std::boolalpha << update << ")" << std::endl;
-
     if (update) {
-        std::cerr << "[DEBUG] Updating grammar..." << std::endl;
         update_grammar();
-    } else {
-        std::cerr << "[DEBUG] Reading parsing table..." << std::endl;
-        read_table();
     }
 
-    std::cerr << "[DEBUG] Setting token matches..." << std::endl;
-    set_matches();
-
-    std::stack<Node<Symbol> *> stack;
-    int index = 0;
     tokens.emplace_back(Eof);
-    int tokens_len = static_cast<int>(tokens.size());
-
-    std::cerr << "[DEBUG] Initializing stack with $ and start symbol." << std::endl;
-    auto *Eof_node = new Node<Symbol>(Symbol("$", TERMINAL), nullptr);
-    stack.push(Eof_node);
-    auto *root = new Node<Symbol>(Symbol(START_VAR, VARIABLE), nullptr);
-    stack.push(root);
-
-    tree.set_root(root);
-
-    while (index < tokens_len && !stack.empty()) {
-        Node<Symbol> *top_node = stack.top();
-        Symbol top_var = top_node->get_data();
-        stack.pop();
-
-        Symbol term = Symbol(match[tokens[index].get_type()], TERMINAL);
-        int line_number = tokens[index].get_line_number();
-        std::string token_content = tokens[index].get_content();
-
-        std::cerr << "[DEBUG] Processing token[" << index << "]: "
-                  << token_content << " (line " << line_number << "), matched as '"
-                  << term.get_name() << "'" << std::endl;
-        std::cerr << "[DEBUG] Top of stack: " << top_var.get_name()
-                  << " (" << (top_var.get_type() == TERMINAL ? "TERMINAL" : "NON-TERMINAL") << ")" << std::endl;
-
-        if (top_var.get_type() == TERMINAL) {
-            if (term == top_var) {
-                std::cerr << "[DEBUG] Terminal matched: " << term.get_name() << std::endl;
-                top_node->get_data().set_content(token_content);
-                top_node->get_data().set_line_number(line_number);
-                index++;
-            } else {
-                std::cerr << RED << "Syntax Error: Terminals don't match, line: " << line_number << WHITE << std::endl;
-                std::cerr << RED << "Expected '" << top_var.get_name() << "', but found '" << term.get_name()
-                          << "' with content '" << token_content << "' instead." << WHITE << std::endl;
-                std::cerr << "[DEBUG] Popping mismatched terminal from stack." << std::endl;
-                num_errors++;
-            }
-        } else {
-            auto it = table.find({top_var, term});
-            if (it != table.end()) {
-                Rule rule = it->second;
-                if (rule.get_type() == VALID) {
-                    std::cerr << "[DEBUG] Applying rule for " << top_var.get_name() << " -> ";
-                    for (const auto &s: rule.get_body()) std::cerr << s.get_name() << " ";
-                    std::cerr << std::endl;
-
-                    top_node->get_data().set_line_number(line_number);
-
-                    std::vector<Symbol> body = rule.get_body();
-                    std::reverse(body.begin(), body.end());
-                    for (const auto &var: body) {
-                        auto *node = new Node<Symbol>(var, top_node);
-                        top_node->push_front_children(node);
-                        if (var != eps) {
-                            stack.push(node);
-                            std::cerr << "[DEBUG] Pushed to stack: " << var.get_name() << std::endl;
-                        }
-                    }
-                } else if (rule.get_type() == SYNCH) {
-                    std::cerr << RED << "Syntax Error: Synchronization attempted, line: " << line_number << WHITE
-                              << std::endl;
-                    std::cerr << "[DEBUG] Skipping tokens until synchronization point for " << top_var.get_name()
-                              << std::endl;
-                    num_errors++;
-                    while (index < tokens_len && follows[top_var].find(term) == follows[top_var].end() &&
-                           term != Symbol("$", TERMINAL)) {
-                        index++;
-                        if (index < tokens_len) {
-                            term = Symbol(match[tokens[index].get_type()], TERMINAL);
-                        }
-                    }
-                    stack.push(top_node);
-                } else if (rule.get_type() == EMPTY) {
-                    std::cerr << RED << "Syntax Error: Empty cell/Unexpected token, line: " << line_number << WHITE
-                              << std::endl;
-                    std::cerr << "[DEBUG] Ignored token '" << term.get_name() << "' for non-terminal '"
-                              << top_var.get_name() << "'" << std::endl;
-                    num_errors++;
-                    index++;
-                    stack.push(top_node);
-                }
-            } else {
-                std::cerr << RED << "Syntax Error: Unexpected input or missing rule, line: " << line_number << WHITE
-                          << std::endl;
-                std::cerr << "[DEBUG] No rule for non-terminal '" << top_var.get_name()
-                          << "' with token '" << term.get_name() << "'" << std::endl;
-                num_errors++;
-                index++;
-                stack.push(top_node);
-            }
-        }
+    exp_id = table.get_variable_id(EXP_VAR);
+    operand_id = table.get_variable_id(OPERAND_VAR);
+    func_id = table.get_variable_id(FUNC_VAR);
+
+#ifdef DIRECT_PARSER
+    direct = grammar_hash == DIRECT_GRAMMAR_HASH;
+    if (!direct) {
+        std::cerr << YELLOW << "Parser Warning: The direct-coded parser was generated from another grammar, "
+                  << "using the parse table" << WHITE << std::endl;
+    }
+#endif
+    run_parser();
+    if (direct && compare_parsers) {
+        check_direct_parser();
     }
 
     if (num_errors == 0) {
@@ -604,8 +552,87 @@ void SyntaxAnalyzer::make_tree(bool update) {
     } else {
         std::cout << YELLOW << "Parsed tree unsuccessfully with " << num_errors << " errors." << WHITE << std::endl;
     }
+}
+
+void SyntaxAnalyzer::run_parser() {
+    std::vector<FunctionParse> functions;
+    if (PARALLEL_PARSER) {
+        parse_functions(functions);
+    }
+
+    Parser parser(*this, std::cerr);
+    parser.functions = &functions;
+    parser.parse_program();
+    events = std::move(parser.events);
+    num_errors = parser.num_errors;
+    tree.reset(&table, &tokens);
+}
+
+/*
+    Parses the top-level functions ahead on worker threads. Every T_Fn at brace depth 0
+    starts one, and a worker parses <func> from there against the shared table and tokens,
+    keeping its diagnostics aside. Parsing a symbol from a given token doesn't depend on
+    anything before it, so the main parse takes a worker's log whenever it reaches a <func>
+    at that token, and the result is the sequential one. Where error recovery carries a
+    function past the next boundary, the main parse simply goes on by itself.
+*/
+void SyntaxAnalyzer::parse_functions(std::vector<FunctionParse> &functions) {
+    int depth = 0;
+    for (int pos = 0; pos < (int) tokens.size(); pos++) {
+        token_type type = tokens[pos].get_type();
+        if (type == T_LC) {
+            depth++;
+        } else if (type == T_RC) {
+            depth = std::max(depth - 1, 0);
+        } else if (type == T_Fn && depth == 0) {
+            functions.emplace_back(pos);
+        }
+    }
+    int num_functions = (int) functions.size();
+    if (num_functions < PARALLEL_MIN_FUNCTIONS) {
+        functions.clear();
+        return;
+    }
+    for (int id = 0; id < num_functions; id++) {
+        functions[id].limit = id + 1 < num_functions ? functions[id + 1].begin + 1 : (int) tokens.size();
+    }
+
+    int num_threads = std::max(1, std::min((int) std::thread::hardware_concurrency(), num_functions));
+    std::atomic<int> next(0);
+    std::vector<std::thread> workers;
+    for (int i = 0; i < num_threads; i++) {
+        workers.emplace_back([this, &functions, &next, num_functions]() {
+            for (int id = next++; id < num_functions; id = next++) {
+                std::ostringstream diagnostics;
+                Parser parser(*this, diagnostics);
+                parser.parse_function(functions[id]);
+                functions[id].diagnostics = diagnostics.str();
+            }
+        });
+    }
+    for (auto &worker: workers) {
+        worker.join();
+    }
+}
+
+// Parses again with the table and fails if the two backends disagree on the event log.
+void SyntaxAnalyzer::check_direct_parser() {
+    ParseEvents direct_events = events;
+    int direct_errors = num_errors;
 
-    std::cerr << "[DEBUG] Exiting make_tree with " << num_errors << " error(s)" << std::endl;
+    std::streambuf *err = std::cerr.rdbuf(nullptr);
+    direct = false;
+    compare_parsers = CHECK_DIRECT_PARSER;
+    run_parser();
+    direct = true;
+    std::cerr.rdbuf(err);
+    std::cerr.clear();
+
+    if (!(events == direct_events) || num_errors != direct_errors) {
+        std::cerr << RED << "Parser Error: The direct-coded parser and the parse table built different trees"
+                  << WHITE << std::endl;
+        exit(PARSER_MISMATCH);
+    }
 }
 
 void SyntaxAnalyzer::write() {
@@ -618,17 +645,56 @@ void SyntaxAnalyzer::write() {
         std::cerr << RED << "File Error: Couldn't open output file" << WHITE << std::endl;
         exit(FILE_ERROR);
     }
-    std::fill(has_par, has_par + 200, false);
-    write_tree(tree.get_root());
+    build_tree();
+    write_tree(out);
     out.close();
+
+    if (!tree.save(out_address + "b", grammar_hash)) {
+        std::cerr << YELLOW << "File Warning: Couldn't write binary tree file" << WHITE << std::endl;
+    }
+}
+
+// Maps a tree written by an earlier run instead of parsing; it must come from the same grammar.
+bool SyntaxAnalyzer::load_tree(const std::string &path) {
+    return tree.load(path) && tree.get_grammar_hash() == grammar_hash;
+}
+
+// the tree is only materialized from the event log when a consumer asks for it
+void SyntaxAnalyzer::build_tree() {
+    if (tree.empty()) {
+        tree.build(&table, &tokens, events);
+    }
 }
 
-Tree<Symbol> SyntaxAnalyzer::get_tree() const {
+const ParseEvents &SyntaxAnalyzer::get_events() const {
+    return events;
+}
+
+const ParseTree &SyntaxAnalyzer::get_tree() {
+    build_tree();
     return tree;
 }
 
+Program *SyntaxAnalyzer::get_ast() const {
+    return ast;
+}
+
+void SyntaxAnalyzer::build_ast() {
+    build_tree();
+    arena.reset();
+    AstBuilder builder(arena);
+    ast = builder.build(tree);
+}
+
+// syntax check only: the event log is validated and no tree is built
+bool SyntaxAnalyzer::check() {
+    make_tree(true);
+    return num_errors == 0;
+}
+
 void SyntaxAnalyzer::run() {
     make_tree(true);
     write();
+    build_ast();
     std::cout << GREEN << "Syntax analysis completed successfully!" << WHITE << std::endl;
 }
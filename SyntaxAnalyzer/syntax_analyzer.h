@@ -2,10 +2,27 @@
 #define SYNTAX_ANALYZER_H
 
 #include "../utils.h"
+#include "parse_table.h"
+#include "parse_tree.h"
+#include "ast_builder.h"
+#include "parser.h"
 
 #define GRAMMAR_PATH "../Test/Grammar.txt"
-#define TABLE_PATH "../Output/table.txt"
+#define TABLE_PATH "../Output/table.bin"
 #define START_VAR "program"
+#define EXP_VAR "exp"
+#define OPERAND_VAR "exp_operand"
+#define FUNC_VAR "func"
+#define DEBUG_PARSER false
+// set by the CHECK_DIRECT_PARSER build option, --compare-parsers turns it on for one run
+#ifndef CHECK_DIRECT_PARSER
+#define CHECK_DIRECT_PARSER false
+#endif
+#define FAST_PARSER true
+#define PARALLEL_PARSER true
+#define PARALLEL_MIN_FUNCTIONS 2
+#define MAX_ERRORS 100
+#define MAX_ERRORS_PER_TOKEN 16
 
 enum rule_type {
     VALID,
@@ -50,16 +67,23 @@ public:
     std::ofstream out;
     std::vector<Token> tokens;
     std::vector<Rule> rules;
-    std::map<Symbol, std::vector<Rule>> self_rules;
     std::set<Symbol> variables, terminals;
-    std::map<Symbol, std::set<Symbol>> firsts, follows;
-    std::map<Symbol, bool> first_done;
-    std::map<Symbol, std::set<Symbol>> graph;
-    std::map<std::pair<Symbol, Symbol>, Rule> table;
+    std::vector<Bitset> firsts, follows;
+    std::vector<bool> nullable;
+    int num_conflicts;
+    ParseTable table;
+    uint64_t grammar_hash;
+    bool direct;
+    bool compare_parsers;
     std::map<token_type, std::string> match;
-    Tree<Symbol> tree;
-    bool has_par[200]{};
+    ParseEvents events;
+    ParseTree tree;
+    uint16_t exp_id, operand_id, func_id;
+    Arena arena;
+    Program *ast;
     int num_errors;
+    int max_errors;
+    tree_format format;
 
     SyntaxAnalyzer(std::vector<Token> _tokens, std::string output_file);
 
@@ -69,41 +93,63 @@ public:
 
     void calc_firsts();
 
-    void calc_first(const Symbol &var);
-
     void print_firsts();
 
-    void print_first(const Symbol &var);
+    void print_first(uint16_t id);
 
     void calc_follows();
 
-    void calc_follow(const Symbol &var);
-
-    void relaxation();
-
     void print_follows();
 
-    void print_follow(const Symbol &var);
+    void print_follow(uint16_t id);
 
     void set_matches();
 
+    void number_symbols();
+
+    void set_table_cell(uint16_t head, uint16_t term, uint16_t rule);
+
     void make_table();
 
-    void write_table();
+    void mark_lists();
 
-    void read_table();
+    void make_sync_sets();
 
-    void write_tree(Node<Symbol> *node, int num = 0, bool last = false);
+    void write_table(uint64_t grammar_hash);
+
+    bool read_table(uint64_t grammar_hash);
+
+    void write_tree(std::ostream &stream);
 
     void update_grammar();
 
+    void build_table(const std::string &grammar_text);
+
     void make_tree(bool update = true);
 
+    void run_parser();
+
+    void parse_functions(std::vector<FunctionParse> &functions);
+
+    void check_direct_parser();
+
     void write();
 
+    bool load_tree(const std::string &path);
+
+    void build_tree();
+
+    void build_ast();
+
+    bool check();
+
     void run();
 
-    Tree<Symbol> get_tree() const;
+    const ParseEvents &get_events() const;
+
+    const ParseTree &get_tree();
+
+    Program *get_ast() const;
 };
 
 #endif // SYNTAX_ANALYZER_H
\ No newline at end of file
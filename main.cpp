@@ -5,22 +5,71 @@
 #include <cstdlib>
 #include <iostream>
 
-int main() {
+int main(int argc, char *argv[]) {
     std::string input_file = "../Test/", output_file = "../Output/", file;
+    bool check_only = false, from_tree = false, compare_parsers = CHECK_DIRECT_PARSER;
+    int max_errors = MAX_ERRORS;
+    tree_format format = TREE_BOX;
+    diag_format diagnostic_format = DIAG_TEXT;
+    const std::map<std::string, tree_format> formats = {{"box", TREE_BOX}, {"compact", TREE_COMPACT},
+                                                         {"json", TREE_JSON}};
+    const std::map<std::string, diag_format> diagnostic_formats = {{"text", DIAG_TEXT}, {"json", DIAG_JSON}};
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--check") {
+            check_only = true;
+        } else if (arg == "--from-synb") {
+            from_tree = true;
+        } else if (arg == "--compare-parsers") {
+            compare_parsers = true;
+        } else if (arg == "--max-errors" && i + 1 < argc && std::atoi(argv[i + 1]) > 0) {
+            max_errors = std::atoi(argv[++i]);
+        } else if (arg == "--tree-format" && i + 1 < argc && formats.count(argv[i + 1])) {
+            format = formats.at(argv[++i]);
+        } else if (arg == "--diagnostics-format" && i + 1 < argc && diagnostic_formats.count(argv[i + 1])) {
+            diagnostic_format = diagnostic_formats.at(argv[++i]);
+        } else {
+            std::cerr << RED << "Usage: TrustCompiler [--check] [--from-synb] [--compare-parsers] [--max-errors N] [--tree-format box|compact|json] [--diagnostics-format text|json]" << WHITE << std::endl;
+            return FAILURE;
+        }
+    }
 
     std::cout << "Enter the file name: ";
     std::cin >> file;
 
-    LexicalAnalyzer lexer(input_file + file, output_file + file + ".lex");
-    lexer.run();
+    // with --from-synb the tree of an earlier run is mapped and lexing and parsing are skipped
+    std::vector<Token> tokens;
+    if (!from_tree) {
+        LexicalAnalyzer lexer(input_file + file, output_file + file + ".lex");
+        lexer.run();
+        tokens = lexer.get_tokens();
+    }
 
-    SyntaxAnalyzer syn_analyzer(lexer.get_tokens(), output_file + file + ".syn");
-    syn_analyzer.run();
+    SyntaxAnalyzer syn_analyzer(std::move(tokens), output_file + file + ".syn");
+    syn_analyzer.max_errors = max_errors;
+    syn_analyzer.format = format;
+    syn_analyzer.compare_parsers = compare_parsers;
+    if (from_tree) {
+        if (!syn_analyzer.load_tree(output_file + file + ".synb")) {
+            std::cerr << RED << "File Error: Couldn't load binary tree file" << WHITE << std::endl;
+            return FILE_ERROR;
+        }
+        syn_analyzer.build_ast();
+    } else if (check_only) {
+        return syn_analyzer.check() ? SUCCESS : FAILURE;
+    } else {
+        syn_analyzer.run();
+    }
 
-    SemanticAnalyzer sem_analyzer(syn_analyzer.get_tree().get_root(), output_file + file + ".sem");
+    SemanticAnalyzer sem_analyzer(syn_analyzer.get_ast(), output_file + file + ".sem");
+    sem_analyzer.format = format;
+    sem_analyzer.cache_address = output_file + file + ".semc";
+    sem_analyzer.max_errors = max_errors;
+    sem_analyzer.diagnostic_format = diagnostic_format;
     sem_analyzer.analyze();
 
-    CodeGenerator code_generator(syn_analyzer.get_tree().get_root(), sem_analyzer.get_symbol_table(),
+    CodeGenerator code_generator(syn_analyzer.get_ast(), sem_analyzer.get_symbol_table(),
+                                 sem_analyzer.get_type_table(),
                                  output_file + file + ".c");
 
     code_generator.run();
@@ -12,11 +12,17 @@
 #include <set>
 #include <utility>
 #include <stack>
+#include <cstdint>
+#include <bit>
+#include <new>
+#include <type_traits>
+#include <cstdio>
 
 #define SUCCESS 0
 #define FAILURE 1
 #define FILE_ERROR 2
 #define GRAMMAR_ERROR 3
+#define PARSER_MISMATCH 4
 
 #define ENDL '\n'
 #define SPACE ' '
@@ -24,6 +30,9 @@
 
 #define COLORED_ERRORS true
 
+#define ARENA_BLOCK_SIZE (64 * 1024)
+#define SINK_BUFFER_SIZE (64 * 1024)
+
 const std::string WHITE = COLORED_ERRORS ? "\033[0;m" : "";
 const std::string RED = COLORED_ERRORS ? "\033[0;31m" : "";
 const std::string GREEN = COLORED_ERRORS ? "\033[0;32m" : "";
@@ -58,6 +67,65 @@ const std::string semantic_type_to_string[] = {
         "unk"
 };
 
+// index of an interned type in the TypeTable, the ones without structure equal their semantic_type
+typedef uint32_t type_id;
+
+enum const_kind {
+    CONST_UNKNOWN,
+    CONST_INT,
+    CONST_BOOL,
+    CONST_ARRAY,
+    CONST_TUPLE
+};
+
+// A value known at compile time: an i32, a bool, or an array or tuple of known values.
+struct ConstValue {
+    const_kind kind = CONST_UNKNOWN;
+    int32_t number = 0;                // the i32, or 0/1 for a bool
+    std::vector<ConstValue> elements;  // array or tuple elements
+
+    static ConstValue of_int(int32_t _number) {
+        ConstValue value;
+        value.kind = CONST_INT;
+        value.number = _number;
+        return value;
+    }
+
+    static ConstValue of_bool(bool _value) {
+        ConstValue value;
+        value.kind = CONST_BOOL;
+        value.number = _value;
+        return value;
+    }
+
+    bool known() const {
+        return kind != CONST_UNKNOWN;
+    }
+
+    bool operator==(const ConstValue &other) const {
+        return kind == other.kind && number == other.number && elements == other.elements;
+    }
+
+    std::string to_string() const {
+        switch (kind) {
+            case CONST_INT:
+                return std::to_string(number);
+            case CONST_BOOL:
+                return number ? "true" : "false";
+            case CONST_ARRAY:
+            case CONST_TUPLE: {
+                std::string text = kind == CONST_ARRAY ? "[" : "(";
+                for (size_t i = 0; i < elements.size(); i++) {
+                    text += (i ? ", " : "") + elements[i].to_string();
+                }
+                return text + (kind == CONST_ARRAY ? "]" : ")");
+            }
+            default:
+                return "";
+        }
+    }
+};
+
 enum token_type {
     T_Bool,
     T_Break,
@@ -114,6 +182,12 @@ enum token_type {
     Eof
 };
 
+enum tree_format {
+    TREE_BOX,
+    TREE_COMPACT,
+    TREE_JSON
+};
+
 enum symbol_type {
     TERMINAL,
     VARIABLE
@@ -191,6 +265,57 @@ inline std::string strip(const std::string &s, char ch = ' ') {
     return (start == std::string::npos) ? "" : s.substr(start, end - start + 1);
 }
 
+inline uint64_t hash_string(const std::string &s, uint64_t seed = 14695981039346656037ULL) {
+    uint64_t hash = seed;
+    for (unsigned char ch: s) {
+        hash ^= ch;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+class Bitset {
+private:
+    std::vector<uint64_t> words;
+
+public:
+    Bitset() = default;
+
+    explicit Bitset(int size) : words((size + 63) / 64, 0) {}
+
+    void set(int index) {
+        words[index >> 6] |= (uint64_t) 1 << (index & 63);
+    }
+
+    bool test(int index) const {
+        return words[index >> 6] >> (index & 63) & 1;
+    }
+
+    // returns true when a bit was added
+    bool merge(const Bitset &other) {
+        bool changed = false;
+        for (size_t i = 0; i < words.size(); i++) {
+            uint64_t word = words[i] | other.words[i];
+            changed |= word != words[i];
+            words[i] = word;
+        }
+        return changed;
+    }
+
+    const std::vector<uint64_t> &get_words() const {
+        return words;
+    }
+
+    template<typename F>
+    void for_each(F f) const {
+        for (size_t i = 0; i < words.size(); i++) {
+            for (uint64_t word = words[i]; word; word &= word - 1) {
+                f((int) (i * 64 + std::countr_zero(word)));
+            }
+        }
+    }
+};
+
 class Token {
 private:
     token_type type;
@@ -204,15 +329,15 @@ public:
         content = _content;
     }
 
-    token_type get_type() {
+    token_type get_type() const {
         return type;
     }
 
-    int get_line_number() {
+    int get_line_number() const {
         return line_number;
     }
 
-    std::string get_content() {
+    const std::string &get_content() const {
         return content;
     }
 
@@ -243,33 +368,25 @@ public:
     }
 };
 
+// A grammar symbol. Parse tree nodes only store its id, their attributes live in the tree's arrays and the AST.
 class Symbol {
 private:
     std::string name;
     symbol_type type;
-    int line_number;
-    std::string content;
-    semantic_type stype;
-    std::vector<semantic_type> params_type;
-    std::vector<semantic_type> tuple_types;
-    std::string val;
-    exp_type exp_t;
 
 public:
-    Symbol() : exp_t(TYPE_UNKNOWN) {}
+    Symbol() : type(TERMINAL) {}
 
-    Symbol(std::string _name, symbol_type _type) : exp_t(TYPE_UNKNOWN) {
+    Symbol(std::string _name, symbol_type _type) {
         name = std::move(_name);
         type = _type;
-        line_number = -1;
-        content = "";
     }
 
     void set_name(std::string _name) {
         name = std::move(_name);
     }
 
-    std::string get_name() const {
+    const std::string &get_name() const {
         return name;
     }
 
@@ -281,74 +398,6 @@ public:
         return type;
     }
 
-    void set_line_number(int _line_number) {
-        line_number = _line_number;
-    }
-
-    int get_line_number() {
-        return line_number;
-    }
-
-    void set_content(std::string _content) {
-        content = _content;
-    }
-
-    std::string get_content() {
-        return content;
-    }
-
-    void set_stype(semantic_type _stype) {
-        stype = _stype;
-    }
-
-    semantic_type get_stype() const {
-        return stype;
-    }
-
-    void set_val(std::string _val) {
-        val = _val;
-    }
-
-    std::string get_val() {
-        return val;
-    }
-
-    void add_to_params_type(semantic_type _stype) {
-        params_type.push_back(_stype);
-    }
-
-    void add_to_params_type(std::vector<semantic_type> &_params_type) {
-        for (auto _stype: _params_type) {
-            params_type.push_back(_stype);
-        }
-    }
-
-    std::vector<semantic_type> &get_params_type() {
-        return params_type;
-    }
-
-    void add_to_tuple_types(semantic_type _stype) {
-        tuple_types.push_back(_stype);
-    }
-
-    void add_to_tuple_types(std::vector<semantic_type> &_tuple_types) {
-        for (auto _stype: _tuple_types) {
-            tuple_types.push_back(_stype);
-        }
-    }
-
-    std::vector<semantic_type> &get_tuple_types() {
-        return tuple_types;
-    }
-
-    void set_exp_type(exp_type _exp_t) {
-        exp_t = _exp_t;
-    }
-
-    exp_type get_exp_type() const {
-        return exp_t;
-    }
-
     bool operator==(const Symbol &other) const {
         return name == other.get_name() && type == other.get_type();
     }
@@ -380,121 +429,304 @@ public:
     }
 };
 
-template<typename T>
-class Node {
+/*
+    Bump allocator for objects that live exactly as long as one compilation.
+
+    Objects are carved out of large blocks and never freed one by one; reset() runs the
+    destructors that were registered (newest first) and rewinds to the first block, so the
+    same blocks are reused by the next compilation without going back to malloc.
+*/
+class Arena {
 private:
-    T data;
-    Node<T> *parent;
-    std::deque<Node<T> *> children;
+    struct Destructor {
+        void (*destroy)(void *);
+        void *object;
+        Destructor *next;
+    };
+
+    std::vector<std::pair<char *, size_t>> blocks;
+    size_t block_index;
+    char *cursor;
+    char *limit;
+    Destructor *destructors;
+
+    void next_block(size_t size) {
+        while (block_index + 1 < blocks.size()) {
+            block_index++;
+            if (blocks[block_index].second >= size) {
+                cursor = blocks[block_index].first;
+                limit = cursor + blocks[block_index].second;
+                return;
+            }
+        }
+        size_t block_size = std::max((size_t) ARENA_BLOCK_SIZE, size);
+        blocks.emplace_back(static_cast<char *>(::operator new(block_size)), block_size);
+        block_index = blocks.size() - 1;
+        cursor = blocks[block_index].first;
+        limit = cursor + block_size;
+    }
 
 public:
-    Node() {
-        data = T();
-        parent = nullptr;
+    Arena() {
+        block_index = 0;
+        cursor = nullptr;
+        limit = nullptr;
+        destructors = nullptr;
     }
 
-    Node(T _data, Node<T> *_parent = nullptr) {
-        data = _data;
-        parent = _parent;
-    }
+    Arena(const Arena &) = delete;
 
-    void set_date(T _data) {
-        data = _data;
-    }
+    Arena &operator=(const Arena &) = delete;
 
-    T &get_data() {
-        return data;
+    ~Arena() {
+        reset();
+        for (auto &block: blocks) {
+            ::operator delete(block.first);
+        }
     }
 
-    void set_parent(Node<T> *_parent) {
-        parent = _parent;
+    void *allocate(size_t size, size_t align) {
+        auto address = reinterpret_cast<uintptr_t>(cursor);
+        uintptr_t aligned = (address + align - 1) & ~(uintptr_t) (align - 1);
+        if (cursor == nullptr || aligned + size > reinterpret_cast<uintptr_t>(limit)) {
+            next_block(size + align);
+            address = reinterpret_cast<uintptr_t>(cursor);
+            aligned = (address + align - 1) & ~(uintptr_t) (align - 1);
+        }
+        cursor = reinterpret_cast<char *>(aligned + size);
+        return reinterpret_cast<void *>(aligned);
+    }
+
+    template<typename T, typename... Args>
+    T *make(Args &&... args) {
+        T *object = new(allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            auto *destructor = new(allocate(sizeof(Destructor), alignof(Destructor))) Destructor;
+            destructor->destroy = [](void *p) { static_cast<T *>(p)->~T(); };
+            destructor->object = object;
+            destructor->next = destructors;
+            destructors = destructor;
+        }
+        return object;
     }
 
-    Node<T> *get_parent() {
-        return parent;
+    void reset() {
+        for (Destructor *destructor = destructors; destructor; destructor = destructor->next) {
+            destructor->destroy(destructor->object);
+        }
+        destructors = nullptr;
+        block_index = 0;
+        cursor = blocks.empty() ? nullptr : blocks[0].first;
+        limit = blocks.empty() ? nullptr : blocks[0].first + blocks[0].second;
     }
 
-    void push_back_children(Node<T> *node) {
-        children.push_back(node);
+    size_t get_capacity() const {
+        size_t capacity = 0;
+        for (auto &block: blocks) {
+            capacity += block.second;
+        }
+        return capacity;
     }
+};
+
+/*
+    Buffered writer for the tree printers: text collects in one block that is handed to the
+    stream when it fills up, so no line goes through the stream machinery on its own.
+*/
+class OutputSink {
+private:
+    std::ostream &out;
+    std::string buffer;
 
-    void push_front_children(Node<T> *node) {
-        children.push_front(node);
+public:
+    explicit OutputSink(std::ostream &_out) : out(_out) {
+        buffer.reserve(SINK_BUFFER_SIZE);
     }
 
-    std::deque<Node<T> *> get_children() {
-        return children;
+    ~OutputSink() {
+        flush();
     }
-};
 
-template<typename T>
-class Tree {
-private:
-    Node<T> *root;
+    OutputSink(const OutputSink &) = delete;
 
-    void _print_tree(Node<T> *node, bool *has_par, int num = 0, bool last = false) {
-        T var = node->get_data();
+    OutputSink &operator=(const OutputSink &) = delete;
 
-        for (int i = 0; i < num * TAB - TAB; i++) {
-            if (has_par[i]) {
-                std::cout << "│";
-            } else {
-                std::cout << " ";
-            }
-        }
-        if (num) {
-            if (last) {
-                std::cout << "└── ";
-            } else {
-                std::cout << "├── ";
-            }
-        }
-        std::cout << var << std::endl;
-        if (node->get_data().get_content() != "") {
-            for (int i = 0; i < num * TAB; i++) {
-                if (has_par[i]) {
-                    std::cout << "│";
-                } else {
-                    std::cout << " ";
-                }
-            }
-            std::cout << "└── '" << node->get_data().get_content() << "'" << std::endl;
-        }
+    void flush() {
+        out.write(buffer.data(), (std::streamsize) buffer.size());
+        buffer.clear();
+    }
 
-        has_par[num * TAB] = true;
-        std::deque<Node<T> *> children = node->get_children();
-        for (auto child: children) {
-            bool end = false;
-            if (child == children.back()) {
-                has_par[num * TAB] = false;
-                end = true;
-            }
-            _print_tree(child, has_par, num + 1, end);
+    OutputSink &operator<<(const std::string &text) {
+        buffer += text;
+        if (buffer.size() >= SINK_BUFFER_SIZE) {
+            flush();
         }
+        return *this;
     }
 
-public:
-    Tree() {
-        root = nullptr;
+    OutputSink &operator<<(const char *text) {
+        buffer += text;
+        if (buffer.size() >= SINK_BUFFER_SIZE) {
+            flush();
+        }
+        return *this;
     }
 
-    Tree(Node<T> *_root) {
-        root = _root;
+    OutputSink &operator<<(char c) {
+        buffer += c;
+        if (buffer.size() >= SINK_BUFFER_SIZE) {
+            flush();
+        }
+        return *this;
     }
 
-    void set_root(Node<T> *_root) {
-        root = _root;
+    OutputSink &operator<<(int value) {
+        return *this << std::to_string(value);
     }
+};
 
-    Node<T> *get_root() {
-        return root;
+inline std::string json_escape(const std::string &s) {
+    std::string res;
+    for (char c: s) {
+        switch (c) {
+            case '"':
+                res += "\\\"";
+                break;
+            case '\\':
+                res += "\\\\";
+                break;
+            case '\n':
+                res += "\\n";
+                break;
+            case '\t':
+                res += "\\t";
+                break;
+            default:
+                if ((unsigned char) c < 0x20) {
+                    char code[8];
+                    snprintf(code, sizeof(code), "\\u%04x", c);
+                    res += code;
+                } else {
+                    res += c;
+                }
+        }
     }
+    return res;
+}
 
-    void print_tree() {
-        bool has_par[200];
-        std::fill(has_par, has_par + 200, false);
-        _print_tree(root, has_par);
-    }
+// what a printer shows for one node; line -1 and empty content or notes are left out
+struct TreeLabel {
+    std::string name;
+    std::string content;
+    int line = -1;
+    std::vector<std::string> notes;
 };
 
+/*
+    Prints a tree with an explicit stack, so nesting depth is only bounded by memory. The
+    caller describes a node by filling a TreeLabel and lists its children by appending them
+    to a vector that is reused for every node.
+
+    TREE_BOX is the box-drawing layout of the .syn and .sem files, TREE_COMPACT indents two
+    spaces per level and TREE_JSON writes nested {"name", "content", "line", "notes",
+    "children"} objects. For the box lines the printer keeps one flag per depth telling
+    whether the node on the current path at that depth has siblings after it.
+*/
+template<typename NodeRef, typename Describe, typename Children>
+void print_tree(OutputSink &sink, NodeRef root, tree_format format, Describe describe, Children children) {
+    struct Frame {
+        NodeRef node;
+        int depth;
+        bool last;
+        bool leave;
+    };
+    std::vector<Frame> stack{{root, 0, true, false}};
+    std::vector<NodeRef> scratch;
+    std::vector<bool> more;
+    TreeLabel label;
+
+    auto indent = [&](int depth) {
+        for (int d = 1; d <= depth; d++) {
+            sink << (more[d] ? "│   " : "    ");
+        }
+    };
+    auto write_notes = [&]() {
+        if (!label.notes.empty()) {
+            sink << "  [ ";
+            for (size_t i = 0; i < label.notes.size(); i++) {
+                sink << label.notes[i] << (i + 1 == label.notes.size() ? "" : ", ");
+            }
+            sink << " ]";
+        }
+    };
+
+    while (!stack.empty()) {
+        Frame frame = stack.back();
+        stack.pop_back();
+        if (frame.leave) {
+            sink << "]}";
+            if (!frame.last) {
+                sink << ',';
+            }
+            continue;
+        }
+
+        label = TreeLabel();
+        describe(frame.node, label);
+        more.resize(frame.depth + 1);
+        more[frame.depth] = !frame.last;
+
+        switch (format) {
+            case TREE_BOX:
+                indent(frame.depth - 1);
+                if (frame.depth) {
+                    sink << (frame.last ? "└── " : "├── ");
+                }
+                sink << label.name;
+                write_notes();
+                sink << '\n';
+                if (!label.content.empty()) {
+                    indent(frame.depth);
+                    sink << "└── '" << label.content << "'\n";
+                }
+                break;
+            case TREE_COMPACT:
+                sink << std::string(frame.depth * 2, ' ') << label.name;
+                if (!label.content.empty()) {
+                    sink << " '" << label.content << "'";
+                }
+                write_notes();
+                sink << '\n';
+                break;
+            case TREE_JSON:
+                sink << "{\"name\":\"" << json_escape(label.name) << '"';
+                if (!label.content.empty()) {
+                    sink << ",\"content\":\"" << json_escape(label.content) << '"';
+                }
+                if (label.line >= 0) {
+                    sink << ",\"line\":" << label.line;
+                }
+                if (!label.notes.empty()) {
+                    sink << ",\"notes\":[";
+                    for (size_t i = 0; i < label.notes.size(); i++) {
+                        sink << (i ? ",\"" : "\"") << json_escape(label.notes[i]) << '"';
+                    }
+                    sink << ']';
+                }
+                sink << ",\"children\":[";
+                stack.push_back({frame.node, frame.depth, frame.last, true});
+                break;
+        }
+
+        scratch.clear();
+        children(frame.node, scratch);
+        for (size_t i = scratch.size(); i-- > 0;) {
+            stack.push_back({scratch[i], frame.depth + 1, i + 1 == scratch.size(), false});
+        }
+    }
+    if (format == TREE_JSON) {
+        sink << '\n';
+    }
+}
+
 #endif // UTILS_H
\ No newline at end of file